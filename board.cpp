@@ -1,8 +1,10 @@
+#include <cctype>
 #include <cmath>
 #include <iostream>
 #include <iomanip>
 #include "board.h"
 #include <cstdlib>
+#include <sstream>
 
 /****************************************************************
 board.cpp
@@ -121,6 +123,35 @@ void Board::addVerticalWall(int r, double c)
 }
 
 
+// Remove an interior horizontal wall
+void Board::removeHorizontalWall(double r, int c)
+{
+  	// verify that the requested wall is valid
+  	// the row coordinate must be a half unit
+  	assert(fabs((r - floor(r)) - 0.5) < 0.005);
+  	// the outer edges of the grid always have walls
+  	assert(r >= 1 && r <= rows);
+  	assert(c >= 1 && c <= cols);
+  	// verify that the wall exists
+  	assert(horizontal_walls[floor(r)][c - 1] == true);
+  	horizontal_walls[floor(r)][c - 1] = false;
+}
+
+// Remove an interior vertical wall
+void Board::removeVerticalWall(int r, double c)
+{
+  	// verify that the requested wall is valid
+  	// the column coordinate must be a half unit
+  	assert(fabs((c - floor(c)) - 0.5) < 0.005);
+  	assert(r >= 1 && r <= rows);
+  	// the outer edges of the grid always have walls
+  	assert(c >= 1 && c <= cols);
+  	// verify that the wall exists
+  	assert(vertical_walls[r - 1][floor(c)] == true);
+  	vertical_walls[r - 1][floor(c)] = false;
+}
+
+
 // PRIVATE HELPER FUNCTIONS related to board geometry
 char Board::getspot(const Position &p) const
 {
@@ -153,7 +184,7 @@ int Board::whichRobot(char a) const
         }
     }
   	std::cerr << "ERROR: Robot " << a << " does not exist" << std::endl;
-  	exit(0);
+  	exit(1);
 }
 
 
@@ -447,11 +478,29 @@ void Board::executeCommand(const command &y)
 {
   moveRobot(whichRobot(y.robot), y.dir);
 }
+
+bool Board::makeMove(int i, unsigned short dir, MoveUndo &undo)
+{
+  	undo.robot = i;
+  	undo.from = robot_positions[i];
+  	return moveRobot(i, dir);
+}
+
+void Board::unmakeMove(const MoveUndo &undo)
+{
+  	setspot(robot_positions[undo.robot], ' ');
+  	robot_positions[undo.robot] = undo.from;
+  	setspot(undo.from, robots[undo.robot]);
+}
+
 //Find a command if possible to cause the transition from one state to another.
-command BuildPlausibleCommand(const Board& a, const Board& b)
+//The moves are tried on 'a' itself, which is put back before returning.
+command BuildPlausibleCommand(Board& a, const Board& b)
 {
   	command command;
-  	Board temp = a;
+  	MoveUndo undo;
+  	//whether 'a' holds a move that still has to be undone
+  	bool moved = false;
   	if (a.robot_positions.size() == b.robot_positions.size())
     {
       	unsigned int single_difference = 0;
@@ -467,10 +516,11 @@ command BuildPlausibleCommand(const Board& a, const Board& b)
       	//iterate through the directions to see what does what.
       	for (unsigned short i = 0; i < 4; i++)
         {
-          	//copy into a temporary variable for comparison.
-          	temp = a;
-          	temp.moveRobot(single_difference, i);
-          	if (temp.robot_positions[single_difference] == b.robot_positions[single_difference])
+          	if (moved)
+            	a.unmakeMove(undo);
+          	a.makeMove(single_difference, i, undo);
+          	moved = true;
+          	if (a.robot_positions[single_difference] == b.robot_positions[single_difference])
             {
               	command.robot = a.robots[single_difference];
               	command.dir = i;
@@ -481,12 +531,279 @@ command BuildPlausibleCommand(const Board& a, const Board& b)
   	for (int i = 0; i < a.robot_positions.size(); i++)
   	{
 	  
-    	if (temp.robot_positions[i] == b.robot_positions[i])
+    	if (a.robot_positions[i] == b.robot_positions[i])
     	{
 		
+      		if (moved)
+        		a.unmakeMove(undo);
       		throw("Huh! It won't work.");
       	}
     }
+  	if (moved)
+    	a.unmakeMove(undo);
   	return command;
 }
 
+
+// Implementation of PuzzleTokens
+
+PuzzleTokens::PuzzleTokens(std::istream &istr_) : istr(istr_), line(1), column(1), word_line(1), word_column(1), pending(false)
+{
+}
+
+bool PuzzleTokens::next(std::string &w)
+{
+  	if (pending)
+    {
+      	pending = false;
+      	w = word;
+      	return !word.empty();
+    }
+  	word.clear();
+  	std::streambuf *in = istr.rdbuf();
+  	// skip the whitespace in front of the word, then read up to the next
+  	for (int c = in->sgetc(); c != EOF; c = in->sgetc())
+    {
+      	if (!isspace(c))
+        {
+          	if (word.empty())
+            {
+              	word_line = line;
+              	word_column = column;
+            }
+          	word += (char)c;
+        }
+      	else if (!word.empty())
+        	break;
+      	in->sbumpc();
+      	if (c == '\n')
+        {
+          	line++;
+          	column = 1;
+        }
+      	else
+        	column++;
+    }
+  	if (word.empty())
+    {
+      	// point at the end of the input
+      	word_line = line;
+      	word_column = column;
+      	return false;
+    }
+  	w = word;
+  	return true;
+}
+
+// at most 9 digits, so the value always fits in an int
+bool PuzzleTokens::nextInt(int &x)
+{
+  	std::string w;
+  	if (!next(w))
+    	return false;
+  	unsigned int i = (w[0] == '-') ? 1 : 0;
+  	if (w.size() == i || w.size() > i + 9)
+    	return false;
+  	x = 0;
+  	for (; i < w.size(); i++)
+    {
+      	if (w[i] < '0' || w[i] > '9')
+        	return false;
+      	x = x * 10 + (w[i] - '0');
+    }
+  	if (w[0] == '-')
+    	x = -x;
+  	return true;
+}
+
+// digits, a point, a 5 and nothing but zeros after it
+bool PuzzleTokens::nextHalf(int &halves)
+{
+  	std::string w;
+  	if (!next(w))
+    	return false;
+  	std::string::size_type point = w.find('.');
+  	if (point == 0 || point == std::string::npos || point > 8 || point + 1 == w.size() || w[point + 1] != '5')
+    	return false;
+  	int n = 0;
+  	for (unsigned int i = 0; i < point; i++)
+    {
+      	if (w[i] < '0' || w[i] > '9')
+        	return false;
+      	n = n * 10 + (w[i] - '0');
+    }
+  	for (unsigned int i = point + 2; i < w.size(); i++)
+    {
+      	if (w[i] != '0')
+        	return false;
+    }
+  	halves = 2 * n + 1;
+  	return true;
+}
+
+std::string PuzzleTokens::where() const
+{
+  	std::ostringstream ostr;
+  	ostr << "line " << word_line << ", column " << word_column << ": ";
+  	return ostr.str();
+}
+
+
+Board readBoard(std::istream &istr, std::string &error)
+{
+  	PuzzleTokens tokens(istr);
+  	return readBoard(tokens, error);
+}
+
+Board readBoard(PuzzleTokens &tokens, std::string &error)
+{
+  	// read in the board dimensions and create an empty board
+  	// (all outer edges are automatically set to be walls)
+  	// each error points at the dimension at fault
+  	int rows, cols;
+  	bool ok = tokens.nextInt(rows) && rows >= 1;
+  	std::string rows_at = tokens.where();
+  	ok = ok && tokens.nextInt(cols) && cols >= 1;
+  	std::string cols_at = tokens.where();
+  	if (!ok)
+    {
+      	error = tokens.where() + "the puzzle must start with the number of rows and columns";
+      	return Board(0, 0);
+    }
+  	if (rows > MAX_BOARD_SIDE || cols > MAX_BOARD_SIDE)
+    {
+      	std::ostringstream ostr;
+      	ostr << "boards larger than " << MAX_BOARD_SIDE << " by " << MAX_BOARD_SIDE << " are not supported";
+      	error = (rows > MAX_BOARD_SIDE ? rows_at : cols_at) + ostr.str();
+      	return Board(0, 0);
+    }
+  	Board answer(rows, cols);
+  	readBoard(tokens, answer, error);
+  	return answer;
+}
+
+// Each statement's errors are reported at its first word, except for a
+// malformed number, which is reported where it is.
+void readBoard(PuzzleTokens &tokens, Board &answer, std::string &error, bool walls)
+{
+  	int rows = answer.getRows(), cols = answer.getCols();
+
+  	// read in the other characteristics of the puzzle board
+  	std::string token;
+  	while (error.empty() && tokens.next(token))
+    {
+      	std::string at = tokens.where();
+      	if (token == "robot")
+        {
+          	std::string name;
+          	int r, c;
+          	if (!tokens.next(name) || !tokens.nextInt(r) || !tokens.nextInt(c))
+            	error = tokens.where() + "robot needs a name, a row and a column";
+          	else if (name.size() != 1 || name[0] < 'A' || name[0] > 'Z')
+            	error = at + "robot name must be a capital letter: " + name;
+          	else if (r < 1 || r > rows || c < 1 || c > cols)
+            	error = at + "robot " + name + " is off the board";
+          	else if (answer.isPositionFilledByRobot(Position(r, c)) || Position(r, c) == answer.getGoal())
+            	error = at + "robot " + name + " is placed on an occupied cell";
+          	else
+            {
+              	for (unsigned int i = 0; i < answer.numRobots(); i++)
+                {
+                  	if (answer.getRobot(i) == name[0])
+                    	error = at + "robot " + name + " is placed twice";
+                }
+            }
+          	if (error.empty())
+            	answer.placeRobot(Position(r, c), name[0]);
+        }
+      	else if ((token == "vertical_wall" || token == "horizontal_wall") && !walls)
+        {
+          	error = at + "the walls of this board are already complete";
+        }
+      	else if (token == "vertical_wall")
+        {
+          	// a row, and the half unit column between two cells
+          	int i, j;
+          	if (!tokens.nextInt(i) || !tokens.nextHalf(j))
+            	error = tokens.where() + "vertical_wall needs a row and a column n.5";
+          	else if (i < 1 || i > rows || j < 3 || j > 2 * cols - 1)
+            	error = at + "vertical_wall is not between two cells of the board";
+          	else if (answer.getVerticalWall(i, j / 2.0))
+            	error = at + "vertical_wall is already there";
+          	else
+            	answer.addVerticalWall(i, j / 2.0);
+        }
+      	else if (token == "horizontal_wall")
+        {
+          	// the half unit row between two cells, and a column
+          	int i, j;
+          	if (!tokens.nextHalf(i) || !tokens.nextInt(j))
+            	error = tokens.where() + "horizontal_wall needs a row n.5 and a column";
+          	else if (i < 3 || i > 2 * rows - 1 || j < 1 || j > cols)
+            	error = at + "horizontal_wall is not between two cells of the board";
+          	else if (answer.getHorizontalWall(i / 2.0, j))
+            	error = at + "horizontal_wall is already there";
+          	else
+            	answer.addHorizontalWall(i / 2.0, j);
+        }
+      	else if (token == "goal")
+        {
+          	std::string which_robot;
+          	int r, c;
+          	if (!tokens.next(which_robot) || !tokens.nextInt(r) || !tokens.nextInt(c))
+            	error = tokens.where() + "goal needs a robot name (or any), a row and a column";
+          	else if (r < 1 || r > rows || c < 1 || c > cols)
+            	error = at + "goal is off the board";
+          	else if (answer.isPositionFilledByRobot(Position(r, c)))
+            	error = at + "goal is placed under a robot";
+          	else if (which_robot != "any")
+            {
+              	error = at + "goal robot " + which_robot + " does not exist";
+              	for (unsigned int i = 0; i < answer.numRobots(); i++)
+                {
+                  	if (which_robot.size() == 1 && answer.getRobot(i) == which_robot[0])
+                    	error.clear();
+                }
+            }
+          	if (error.empty())
+            	answer.setGoal(which_robot, Position(r, c));
+        }
+      	else
+        {
+          	error = at + "unknown token in the input file " + token;
+        }
+    }
+}
+
+void writeBoard(std::ostream &ostr, const Board &b)
+{
+  	ostr << b.getRows() << " " << b.getCols() << '\n';
+  	for (unsigned int i = 0; i < b.numRobots(); i++)
+    	ostr << "robot " << b.getRobot(i) << " " << b.getRobotPosition(i).row << " " << b.getRobotPosition(i).col << '\n';
+  	// the outer edges always have walls, so only the interior ones are listed
+  	for (int r = 1; r <= b.getRows(); r++)
+    {
+      	for (int c = 1; c < b.getCols(); c++)
+        {
+          	if (b.getVerticalWall(r, c + 0.5))
+            	ostr << "vertical_wall " << r << " " << c + 0.5 << '\n';
+        }
+    }
+  	for (int r = 1; r < b.getRows(); r++)
+    {
+      	for (int c = 1; c <= b.getCols(); c++)
+        {
+          	if (b.getHorizontalWall(r + 0.5, c))
+            	ostr << "horizontal_wall " << r + 0.5 << " " << c << '\n';
+        }
+    }
+  	if (b.getGoal().row != -1)
+    {
+      	ostr << "goal ";
+      	if (b.getGoalRobot() == -1)
+        	ostr << "any";
+      	else
+        	ostr << b.getRobot(b.getGoalRobot());
+      	ostr << " " << b.getGoal().row << " " << b.getGoal().col << '\n';
+    }
+}
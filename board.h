@@ -33,6 +33,53 @@ bool operator==(const Position &a, const Position &b);
 bool operator!=(const Position &a, const Position &b);
 
 
+// the most rows or columns a puzzle may have; a Board and its Geometry
+// allocate their tables for every cell as soon as they are created
+const int MAX_BOARD_SIDE = 1024;
+
+// ==================================================================
+// Splits a puzzle into whitespace separated words, remembering the line
+// and column each one starts at so errors can point at it.  Numbers are
+// read exactly: a wall coordinate n.5 comes back as 2n + 1 half units.
+
+class PuzzleTokens
+{
+	public:
+  		PuzzleTokens(std::istream &istr);
+
+  		// false at the end of the input
+  		bool next(std::string &word);
+  		// false if the next word is missing or is not a whole number
+  		bool nextInt(int &x);
+  		// false if the next word is missing or is not n.5 for a whole n
+  		bool nextHalf(int &halves);
+  		// make next() return the last word again, or false again if the
+  		// last call found the end of the input
+  		void unread()
+  		{
+    		pending = true;
+  		}
+
+  		// ACCESSOR: "line 3, column 7: ", where the last word read starts
+  		std::string where() const;
+
+	private:
+  		// REPRESENTATION
+  		std::istream &istr;
+  		// where the next character read is, and where the last word started
+  		int line, column;
+  		int word_line, word_column;
+  		std::string word;
+  		bool pending;
+};
+
+// What Board::makeMove changed: the robot that moved and where it was
+struct MoveUndo
+{
+  	int robot;
+  	Position from;
+};
+
 // ==================================================================
 // A class to hold information about the puzzle board including the
 // dimensions, the location of all walls, the current position of all
@@ -45,7 +92,8 @@ class Board
 		//friend functions are able to access its members even being as an outsider
 		//This functions returns a structure of type struct command which is defined for our convinient
 		
-  		friend command BuildPlausibleCommand(const Board&, const Board&); 
+  		friend command BuildPlausibleCommand(Board&, const Board&); 
+  		friend void readBoard(PuzzleTokens&, Board&, std::string&, bool);
     	Board(int num_rows, int num_cols); //Non-inline constructor that is defined inside board.cpp
 
   		// ACCESSORS
@@ -94,6 +142,8 @@ class Board
   		// MODIFIERS related to board geometry
   		void addHorizontalWall(double r, int c);
   		void addVerticalWall(int r, double c);
+  		void removeHorizontalWall(double r, int c);
+  		void removeVerticalWall(int r, double c);
 
   		// MODIFIERS related robot position
   		// initial placement of a new robot
@@ -101,6 +151,11 @@ class Board
   		// move an existing robot
   		bool moveRobot(int i, const std::string &direction);
   		bool moveRobot(int i, unsigned short direction);
+  		// Move a robot in place, filling in what unmakeMove needs to put it
+  		// back exactly.  A search can then explore from a single board
+  		// instead of copying it for every child.
+  		bool makeMove(int i, unsigned short direction, MoveUndo &undo);
+  		void unmakeMove(const MoveUndo &undo);
   		// MODIFIER related to the puzzle goal
   		void setGoal(const std::string &goal_robot, const Position &p);
 
@@ -139,4 +194,21 @@ class Board
   		// the goal robot is -1 if the puzzle is solved if any robot reaches the goal
   		int goal_robot;
 };
+
+// Read a puzzle in the puzzle file format.  If the input is malformed,
+// would break one of the rules the modifiers assert, or is larger than
+// MAX_BOARD_SIDE, 'error' is set to a description starting with the
+// line and column of the problem, and the partially read board is
+// returned.
+Board readBoard(std::istream &istr, std::string &error);
+Board readBoard(PuzzleTokens &tokens, std::string &error);
+// Read the rest of a puzzle, after the dimensions, onto a board that
+// already exists, such as one put together from tiles.  If 'walls' is
+// false the board's walls are complete and a wall is an error.
+void readBoard(PuzzleTokens &tokens, Board &b, std::string &error, bool walls = true);
+
+// Write the board in the puzzle file format: the dimensions, the robots
+// where they are now, the interior walls and the goal.  readBoard reads
+// it back to an equal board.
+void writeBoard(std::ostream &ostr, const Board &b);
 #endif
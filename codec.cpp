@@ -0,0 +1,87 @@
+#include "codec.h"
+
+/****************************************************************
+codec.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Packs robot positions using only the cells robots can rest on
+
+*****************************************************************/
+
+
+StateCodec::StateCodec(const Geometry &g, const int *start, int count_, int max_depth)
+{
+	count = count_;
+	int n = g.numCells();
+
+	// rest[i][cell] is 1 if robot i may be on the cell after the moves so far
+	std::vector<std::vector<char> > rest(count, std::vector<char>(n, 0));
+	for (int i = 0; i < count; i++)
+		rest[i][start[i]] = 1;
+
+	bool grew = true;
+	for (int depth = 1; grew && (max_depth < 0 || depth <= max_depth); depth++)
+	{
+		grew = false;
+		std::vector<std::vector<char> > next = rest;
+		for (int i = 0; i < count; i++)
+		{
+			// the cells some other robot may be standing on
+			std::vector<char> others(n, 0);
+			for (int j = 0; j < count; j++)
+			{
+				if (j == i)
+					continue;
+				for (int cell = 0; cell < n; cell++)
+					others[cell] |= rest[j][cell];
+			}
+
+			// slide from every possible cell; the robot may stop at the wall,
+			// or in front of any cell another robot could be on
+			for (int from = 0; from < n; from++)
+			{
+				if (!rest[i][from])
+					continue;
+				for (unsigned short d = 0; d < 4; d++)
+				{
+					for (int cell = from; !(g.getWalls(cell) & (1 << d)); )
+					{
+						int ahead = g.step(cell, d);
+						if (others[ahead] && cell != from && !next[i][cell])
+						{
+							next[i][cell] = 1;
+							grew = true;
+						}
+						cell = ahead;
+						if ((g.getWalls(cell) & (1 << d)) && !next[i][cell])
+						{
+							next[i][cell] = 1;
+							grew = true;
+						}
+					}
+				}
+			}
+		}
+		rest.swap(next);
+	}
+
+	// number the rest cells of each robot
+	total_bits = 0;
+	index = std::vector<std::vector<int> >(count, std::vector<int>(n, -1));
+	cells = std::vector<std::vector<int> >(count);
+	for (int i = 0; i < count; i++)
+	{
+		for (int cell = 0; cell < n; cell++)
+		{
+			if (rest[i][cell])
+			{
+				index[i][cell] = cells[i].size();
+				cells[i].push_back(cell);
+			}
+		}
+		bits[i] = 0;
+		while (((unsigned int)1 << bits[i]) < cells[i].size())
+			bits[i]++;
+		total_bits += bits[i];
+	}
+}
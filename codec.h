@@ -0,0 +1,79 @@
+#include <vector>
+
+#include "geometry.h"
+
+/****************************************************************
+codec.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Packs robot positions using only the cells robots can rest on
+
+*****************************************************************/
+
+#ifndef CODEC_H
+#define CODEC_H
+
+// all robot positions packed into one integer
+typedef unsigned long long StateKey;
+
+// ==================================================================
+// A robot only ever rests where a slide stops: against a wall, against
+// another robot, or on its starting cell.  The constructor finds, for
+// each robot, every cell it could rest on within max_depth moves and
+// numbers them densely, so a robot needs only enough bits for its own
+// rest cells instead of a full cell index.
+//
+// The analysis is conservative.  A robot moving along a line is assumed
+// able to stop in front of any cell that another robot could occupy by
+// then, whether or not that robot is really there, so the result is a
+// superset of the true rest cells and every reachable state can be
+// packed.
+
+class StateCodec
+{
+	public:
+		// max_depth < 0 keeps going until no robot gains a rest cell
+		StateCodec(const Geometry &g, const int *start, int count, int max_depth);
+
+		// ACCESSORS
+		int numRestCells(int i) const
+		{
+			return cells[i].size();
+		}
+		int totalBits() const
+		{
+			return total_bits;
+		}
+		// true if every state fits in a StateKey
+		bool fits() const
+		{
+			return total_bits <= 64;
+		}
+
+		StateKey pack(const int *robots) const
+		{
+			StateKey key = 0;
+			for (int i = count - 1; i >= 0; i--)
+				key = (key << bits[i]) | (StateKey)index[i][robots[i]];
+			return key;
+		}
+		void unpack(StateKey key, int *robots) const
+		{
+			for (int i = 0; i < count; i++)
+			{
+				robots[i] = cells[i][key & (((StateKey)1 << bits[i]) - 1)];
+				key >>= bits[i];
+			}
+		}
+
+	private:
+		// REPRESENTATION
+		int count;
+		int bits[MAX_ROBOTS];
+		int total_bits;
+		// per robot, the dense number of each cell (-1 if it never rests there)
+		std::vector<std::vector<int> > index;
+		// per robot, the cell of each dense number
+		std::vector<std::vector<int> > cells;
+};
+#endif
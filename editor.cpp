@@ -0,0 +1,117 @@
+#include "editor.h"
+#include "goaltable.h"
+#include "solver.h"
+
+/****************************************************************
+editor.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Wall editing with the derived tables kept up to date
+
+*****************************************************************/
+
+
+Editor::Editor(const Board &b, int max_depth_) : board(b), geometry(b), max_depth(max_depth_)
+{
+	invalidate();
+}
+
+void Editor::invalidate()
+{
+	have_difficulty = false;
+	have_accessibility = false;
+}
+
+// a wall between two rows of cells, not on the outer edge
+bool Editor::isInteriorHorizontalWall(int half_r, int c) const
+{
+	return half_r % 2 == 1 && half_r >= 3 && half_r <= 2 * board.getRows() - 1 && c >= 1 && c <= board.getCols();
+}
+
+// a wall between two columns of cells, not on the outer edge
+bool Editor::isInteriorVerticalWall(int r, int half_c) const
+{
+	return half_c % 2 == 1 && r >= 1 && r <= board.getRows() && half_c >= 3 && half_c <= 2 * board.getCols() - 1;
+}
+
+bool Editor::addHorizontalWall(int half_r, int c)
+{
+	if (!isInteriorHorizontalWall(half_r, c) || board.getHorizontalWall(half_r / 2.0, c))
+		return false;
+	board.addHorizontalWall(half_r / 2.0, c);
+	geometry.setHorizontalWall(half_r / 2.0, c, true);
+	invalidate();
+	return true;
+}
+
+bool Editor::addVerticalWall(int r, int half_c)
+{
+	if (!isInteriorVerticalWall(r, half_c) || board.getVerticalWall(r, half_c / 2.0))
+		return false;
+	board.addVerticalWall(r, half_c / 2.0);
+	geometry.setVerticalWall(r, half_c / 2.0, true);
+	invalidate();
+	return true;
+}
+
+bool Editor::removeHorizontalWall(int half_r, int c)
+{
+	if (!isInteriorHorizontalWall(half_r, c) || !board.getHorizontalWall(half_r / 2.0, c))
+		return false;
+	board.removeHorizontalWall(half_r / 2.0, c);
+	geometry.setHorizontalWall(half_r / 2.0, c, false);
+	invalidate();
+	return true;
+}
+
+bool Editor::removeVerticalWall(int r, int half_c)
+{
+	if (!isInteriorVerticalWall(r, half_c) || !board.getVerticalWall(r, half_c / 2.0))
+		return false;
+	board.removeVerticalWall(r, half_c / 2.0);
+	geometry.setVerticalWall(r, half_c / 2.0, false);
+	invalidate();
+	return true;
+}
+
+int Editor::getDifficulty()
+{
+	if (!have_difficulty)
+	{
+		// an edit that walls the goal off needs no search to notice
+		std::string error;
+		if (checkPuzzle(board, getGeometry(), error) == PUZZLE_UNSOLVABLE)
+			difficulty = -1;
+		else
+			difficulty = shortestSolution(board, geometry, max_depth);
+		have_difficulty = true;
+	}
+	return difficulty;
+}
+
+const std::vector<std::vector<int> >& Editor::getAccessibility()
+{
+	if (!have_accessibility)
+	{
+		GoalTable table(board, getGeometry(), max_depth);
+		have_accessibility = true;
+		if (!table.fits())
+		{
+			accessibility.clear();
+			return accessibility;
+		}
+		accessibility = std::vector<std::vector<int> >(board.getRows(), std::vector<int>(board.getCols()));
+		for (int r = 1; r <= board.getRows(); r++)
+		{
+			for (int c = 1; c <= board.getCols(); c++)
+				accessibility[r - 1][c - 1] = table.getMoves(-1, Position(r, c));
+		}
+		// the table holds the shortest solution for the board's own goal too
+		if (board.getGoal().row != -1)
+		{
+			difficulty = table.getMoves(board.getGoalRobot(), board.getGoal());
+			have_difficulty = true;
+		}
+	}
+	return accessibility;
+}
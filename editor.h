@@ -0,0 +1,75 @@
+#include <vector>
+
+#include "board.h"
+#include "geometry.h"
+
+/****************************************************************
+editor.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Wall editing with the derived tables kept up to date
+
+*****************************************************************/
+
+#ifndef EDITOR_H
+#define EDITOR_H
+
+// ==================================================================
+// A Board being edited, together with its Geometry.  Each wall edit
+// updates the Geometry in place instead of rebuilding it, and drops the
+// cached difficulty and accessibility map.  Nothing is recomputed until
+// it is asked for, so a run of edits costs only the row or column stops
+// it changes.  The difficulty is a breadth first search that stops at
+// the shortest solution; the map searches every state up to max_depth,
+// and gives the difficulty as well.
+
+class Editor
+{
+	public:
+		Editor(const Board &b, int max_depth);
+
+		// MODIFIERS related to board geometry.  The row of a horizontal
+		// wall and the column of a vertical one are in half units, as
+		// PuzzleTokens::nextHalf reads them: n.5 is 2n + 1.  Each returns
+		// false, and changes nothing, if the wall is not between two cells
+		// of the board or is already there (or, for removal, is not there).
+		bool addHorizontalWall(int half_r, int c);
+		bool addVerticalWall(int r, int half_c);
+		bool removeHorizontalWall(int half_r, int c);
+		bool removeVerticalWall(int r, int half_c);
+
+		// ACCESSORS
+		const Board& getBoard() const
+		{
+			return board;
+		}
+		// with the goal distance brought up to date
+		const Geometry& getGeometry()
+		{
+			geometry.updateGoalDistance();
+			return geometry;
+		}
+		// the number of moves in the shortest solution, or -1 if there is
+		// none within max_depth moves
+		int getDifficulty();
+		// the -visualize map: for each cell the fewest moves for any robot
+		// to reach it, or -1 if it takes more than max_depth moves.  Empty
+		// if the robots' positions do not fit in a StateKey.
+		const std::vector<std::vector<int> >& getAccessibility();
+
+	private:
+		bool isInteriorHorizontalWall(int half_r, int c) const;
+		bool isInteriorVerticalWall(int r, int half_c) const;
+		void invalidate();
+
+		// REPRESENTATION
+		Board board;
+		Geometry geometry;
+		int max_depth;
+		// the cached results, valid until the next edit
+		bool have_difficulty;
+		int difficulty;
+		bool have_accessibility;
+		std::vector<std::vector<int> > accessibility;
+};
+#endif
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+#include "frontier.h"
+
+/****************************************************************
+frontier.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Compact storage for the states of a breadth first search
+
+*****************************************************************/
+
+
+double estimateStates(const StateCodec &codec, int count, int max_depth)
+{
+	double keys = 1;
+	for (int i = 0; i < count; i++)
+		keys *= codec.numRestCells(i);
+	// every position has at most 4 moves per robot
+	double tree = 1, layer = 1;
+	for (int depth = 1; (max_depth < 0 || depth <= max_depth) && tree < keys; depth++)
+	{
+		layer *= 4 * count;
+		tree += layer;
+	}
+	return std::min(keys, tree);
+}
+
+StateStorage chooseStorage(const StateCodec &codec, int count, int max_depth)
+{
+	double states = estimateStates(codec, count, max_depth);
+	if (states <= SMALL_SEARCH_STATES)
+		return HASH_STORAGE;
+	// the sorted lists take around two bytes per state
+	double bitmap = ldexp(1.0, codec.totalBits()) / 8;
+	if (bitmap <= MAX_BITMAP_BYTES && bitmap <= states * 2)
+		return BITMAP_STORAGE;
+	return SORTED_STORAGE;
+}
+
+
+// ==================================================================
+// CompressedKeys
+
+void CompressedKeys::flush()
+{
+	if (buffer.empty())
+		return;
+	std::sort(buffer.begin(), buffer.end());
+	buffer.erase(std::unique(buffer.begin(), buffer.end()), buffer.end());
+	Run run;
+	run.begin = bytes.size();
+	StateKey previous = 0;
+	for (unsigned int k = 0; k < buffer.size(); k++)
+	{
+		// 7 bits per byte, the high bit set on all but the last
+		StateKey delta = buffer[k] - previous;
+		while (delta >= 0x80)
+		{
+			bytes.push_back((unsigned char)(delta | 0x80));
+			delta >>= 7;
+		}
+		bytes.push_back((unsigned char)delta);
+		previous = buffer[k];
+	}
+	run.end = bytes.size();
+	runs.push_back(run);
+	count += buffer.size();
+	buffer.clear();
+}
+
+void CompressedKeys::clear()
+{
+	bytes.clear();
+	runs.clear();
+	buffer.clear();
+	count = 0;
+}
+
+void CompressedKeys::swap(CompressedKeys &other)
+{
+	bytes.swap(other.bytes);
+	runs.swap(other.runs);
+	buffer.swap(other.buffer);
+	std::swap(count, other.count);
+}
+
+CompressedKeys::Reader::Reader(const CompressedKeys &k) : keys(&k), run(0), last_run(k.runs.size()), pos(0), previous(0)
+{
+	if (run < last_run)
+		pos = keys->runs[run].begin;
+}
+
+CompressedKeys::Reader::Reader(const CompressedKeys &k, unsigned int r) : keys(&k), run(r), last_run(r + 1), pos(k.runs[r].begin), previous(0)
+{
+}
+
+bool CompressedKeys::Reader::next(StateKey &key)
+{
+	while (run < last_run && pos == keys->runs[run].end)
+	{
+		if (++run < last_run)
+		{
+			pos = keys->runs[run].begin;
+			previous = 0;
+		}
+	}
+	if (run >= last_run)
+		return false;
+	StateKey delta = 0;
+	for (int shift = 0; ; shift += 7)
+	{
+		unsigned char byte = keys->bytes[pos++];
+		delta |= (StateKey)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			break;
+	}
+	key = previous = previous + delta;
+	return true;
+}
+
+void CompressedKeys::subtract(const CompressedKeys &keys, CompressedKeys &visited, CompressedKeys &layer)
+{
+	// merge the runs of 'keys' smallest first, alongside the visited list
+	typedef std::pair<StateKey, unsigned int> Head;
+	std::priority_queue<Head, std::vector<Head>, std::greater<Head> > heads;
+	std::vector<Reader> readers;
+	for (unsigned int r = 0; r < keys.runs.size(); r++)
+	{
+		readers.push_back(Reader(keys, r));
+		StateKey key;
+		if (readers[r].next(key))
+			heads.push(Head(key, r));
+	}
+
+	CompressedKeys merged;
+	StateKey seen;
+	Reader old(visited);
+	bool more_seen = old.next(seen);
+	bool have_last = false;
+	StateKey last = 0;
+	while (!heads.empty())
+	{
+		Head head = heads.top();
+		heads.pop();
+		StateKey key;
+		if (readers[head.second].next(key))
+			heads.push(Head(key, head.second));
+		if (have_last && head.first == last)
+			continue;
+		have_last = true;
+		last = head.first;
+		while (more_seen && seen < head.first)
+		{
+			merged.push_back(seen);
+			more_seen = old.next(seen);
+		}
+		if (more_seen && seen == head.first)
+			continue;
+		merged.push_back(head.first);
+		layer.push_back(head.first);
+	}
+	while (more_seen)
+	{
+		merged.push_back(seen);
+		more_seen = old.next(seen);
+	}
+	merged.flush();
+	layer.flush();
+
+	visited.swap(merged);
+}
@@ -0,0 +1,145 @@
+#include <cstddef>
+#include <vector>
+
+#include "codec.h"
+
+/****************************************************************
+frontier.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Compact storage for the states of a breadth first search
+
+*****************************************************************/
+
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+// How a breadth first search remembers the states it has seen.
+enum StateStorage
+{
+	// a StateSet and a plain vector per layer: fastest, but around 20
+	// bytes per state
+	HASH_STORAGE,
+	// one bit per possible StateKey, with compressed layers; for searches
+	// that visit a good part of all the keys the codec can produce
+	BITMAP_STORAGE,
+	// compressed sorted layers and visited set, duplicates removed by
+	// merging once per layer; a byte or two per state
+	SORTED_STORAGE,
+	// let chooseStorage decide
+	AUTOMATIC_STORAGE
+};
+
+// searches expected to stay under this many states use HASH_STORAGE
+const double SMALL_SEARCH_STATES = 1 << 20;
+// the largest visited bitmap BITMAP_STORAGE may allocate
+const double MAX_BITMAP_BYTES = 1ULL << 31;
+
+// A rough upper bound on the states a search to max_depth can visit:
+// the smaller of the number of keys with every robot on one of its rest
+// cells and the size of the search tree.
+double estimateStates(const StateCodec &codec, int count, int max_depth);
+
+// The storage a search from these positions should use
+StateStorage chooseStorage(const StateCodec &codec, int count, int max_depth);
+
+// ==================================================================
+// A list of StateKeys held in runs of sorted, deduplicated keys, each
+// key written as the varint encoded difference from the one before.
+// Keys are collected in a buffer and written out as a run whenever
+// RUN_KEYS of them have been added, so a list built from keys in
+// increasing order reads back in increasing order.
+
+class CompressedKeys
+{
+	public:
+		static const unsigned int RUN_KEYS = 1 << 16;
+
+		CompressedKeys() : count(0)
+		{
+		}
+
+		void push_back(StateKey key)
+		{
+			buffer.push_back(key);
+			if (buffer.size() == RUN_KEYS)
+				flush();
+		}
+		// write out the buffered keys; call before reading
+		void flush();
+		void clear();
+		void swap(CompressedKeys &other);
+
+		// ACCESSORS
+		bool empty() const
+		{
+			return count == 0 && buffer.empty();
+		}
+		// keys written out, after removing duplicates within each run
+		size_t size() const
+		{
+			return count;
+		}
+
+		// Reads one run, or every run one after the other
+		class Reader
+		{
+			public:
+				Reader(const CompressedKeys &keys);
+				Reader(const CompressedKeys &keys, unsigned int run);
+				// false at the end
+				bool next(StateKey &key);
+
+			private:
+				const CompressedKeys *keys;
+				unsigned int run;
+				unsigned int last_run;
+				size_t pos;
+				StateKey previous;
+		};
+
+		// Every key in 'keys' that is not in 'visited', once each and in
+		// increasing order, is appended to 'layer' and merged into
+		// 'visited'.  'visited' must have been built in increasing order.
+		static void subtract(const CompressedKeys &keys, CompressedKeys &visited, CompressedKeys &layer);
+
+	private:
+		struct Run
+		{
+			size_t begin;
+			size_t end;
+		};
+
+		// REPRESENTATION
+		std::vector<unsigned char> bytes;
+		std::vector<Run> runs;
+		std::vector<StateKey> buffer;
+		size_t count;
+};
+
+// ==================================================================
+// One bit for every StateKey of 'bits' bits
+
+class StateBitmap
+{
+	public:
+		StateBitmap(int bits) : words(((size_t)1 << bits) / 64 + 1, 0)
+		{
+		}
+
+		// sets the key's bit, returning false if it was already set
+		bool insert(StateKey key)
+		{
+			unsigned long long mask = 1ULL << (key % 64);
+			unsigned long long &word = words[key / 64];
+			if (word & mask)
+				return false;
+			word |= mask;
+			return true;
+		}
+
+	private:
+		// REPRESENTATION
+		std::vector<unsigned long long> words;
+};
+#endif
@@ -0,0 +1,204 @@
+#include "geometry.h"
+#include "trace.h"
+
+/****************************************************************
+geometry.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Precomputed wall tables shared by the fast solvers
+
+*****************************************************************/
+
+
+const char* directionName(unsigned short dir)
+{
+	static const char* const names[4] = { "north", "east", "south", "west" };
+	return dir < 4 ? names[dir] : "";
+}
+
+
+Geometry::Geometry(const Board &b)
+{
+	TraceSpan span("geometry");
+	rows = b.getRows();
+	cols = b.getCols();
+	offset[NORTH] = -cols;
+	offset[EAST] = 1;
+	offset[SOUTH] = cols;
+	offset[WEST] = -1;
+
+	// collect the four walls around every cell into one bit mask
+	walls = std::vector<unsigned char>(rows * cols, 0);
+	for (int r = 1; r <= rows; r++)
+	{
+		for (int c = 1; c <= cols; c++)
+		{
+			unsigned char w = 0;
+			if (b.getHorizontalWall(r - 0.5, c))
+				w |= 1 << NORTH;
+			if (b.getVerticalWall(r, c + 0.5))
+				w |= 1 << EAST;
+			if (b.getHorizontalWall(r + 0.5, c))
+				w |= 1 << SOUTH;
+			if (b.getVerticalWall(r, c - 0.5))
+				w |= 1 << WEST;
+			walls[cellIndex(Position(r, c))] = w;
+		}
+	}
+
+	stops = std::vector<int>(rows * cols * 4);
+	for (int r = 1; r <= rows; r++)
+		computeRowStops(r);
+	for (int c = 1; c <= cols; c++)
+		computeColumnStops(c);
+	computeGoalDistance(b.getGoal());
+}
+
+Geometry::Geometry(const Board &b, const std::vector<unsigned char> &walls_, const std::vector<int> &stops_)
+	: walls(walls_), stops(stops_)
+{
+	rows = b.getRows();
+	cols = b.getCols();
+	offset[NORTH] = -cols;
+	offset[EAST] = 1;
+	offset[SOUTH] = cols;
+	offset[WEST] = -1;
+	computeGoalDistance(b.getGoal());
+}
+
+// Sweep a row from each end: a cell stops a slide itself if it has a wall
+// on that side, otherwise the slide continues to wherever its neighbour's
+// slide stops.  The outer edges always have walls so slides cannot leave
+// the board.
+void Geometry::computeRowStops(int r)
+{
+	int first = cellIndex(Position(r, 1));
+	int last = first + cols - 1;
+	for (int cell = first; cell <= last; cell++)
+		stops[cell * 4 + WEST] = (walls[cell] & (1 << WEST)) ? cell : stops[(cell - 1) * 4 + WEST];
+	for (int cell = last; cell >= first; cell--)
+		stops[cell * 4 + EAST] = (walls[cell] & (1 << EAST)) ? cell : stops[(cell + 1) * 4 + EAST];
+}
+
+void Geometry::computeColumnStops(int c)
+{
+	int first = cellIndex(Position(1, c));
+	int last = cellIndex(Position(rows, c));
+	for (int cell = first; cell <= last; cell += cols)
+		stops[cell * 4 + NORTH] = (walls[cell] & (1 << NORTH)) ? cell : stops[(cell - cols) * 4 + NORTH];
+	for (int cell = last; cell >= first; cell -= cols)
+		stops[cell * 4 + SOUTH] = (walls[cell] & (1 << SOUTH)) ? cell : stops[(cell + cols) * 4 + SOUTH];
+}
+
+// A horizontal wall only changes the north and south slides of its
+// column, so only that column's stops are recomputed.
+void Geometry::setHorizontalWall(double r, int c, bool present)
+{
+	int above = (int)floor(r);
+	if (above >= 1)
+		setWall(cellIndex(Position(above, c)), SOUTH, present);
+	if (above + 1 <= rows)
+		setWall(cellIndex(Position(above + 1, c)), NORTH, present);
+	computeColumnStops(c);
+	stale_goal_distance = true;
+}
+
+// likewise a vertical wall only changes the east and west slides of its row
+void Geometry::setVerticalWall(int r, double c, bool present)
+{
+	int left = (int)floor(c);
+	if (left >= 1)
+		setWall(cellIndex(Position(r, left)), EAST, present);
+	if (left + 1 <= cols)
+		setWall(cellIndex(Position(r, left + 1)), WEST, present);
+	computeRowStops(r);
+	stale_goal_distance = true;
+}
+
+void Geometry::updateGoalDistance()
+{
+	if (stale_goal_distance)
+		computeGoalDistance(goal == -1 ? Position() : cellPosition(goal));
+}
+
+void Geometry::setWall(int cell, unsigned short dir, bool present)
+{
+	if (present)
+		walls[cell] |= 1 << dir;
+	else
+		walls[cell] &= ~(1 << dir);
+}
+
+// Breadth first search outward from the goal.  A robot may be stopped
+// anywhere along a line by another robot, so every cell on an unwalled
+// line through a cell at distance k is at most k + 1 moves away.  This
+// never overestimates and is used to prune the depth limited searches.
+void Geometry::computeGoalDistance(const Position &p)
+{
+	goal_distance = std::vector<unsigned char>(rows * cols, UNREACHABLE);
+	stale_goal_distance = false;
+	goal = -1;
+	if (p.row < 1 || p.row > rows || p.col < 1 || p.col > cols)
+		return;
+	goal = cellIndex(p);
+
+	std::vector<int> queue;
+	queue.reserve(rows * cols);
+	queue.push_back(goal);
+	goal_distance[queue[0]] = 0;
+	for (unsigned int next = 0; next < queue.size(); next++)
+	{
+		int cell = queue[next];
+		// a distance that does not fit is stored as the largest that does,
+		// which is still a lower bound, so UNREACHABLE always means it
+		unsigned char dist = goal_distance[cell] == UNREACHABLE - 1 ? UNREACHABLE - 1 : goal_distance[cell] + 1;
+		for (unsigned short d = 0; d < 4; d++)
+		{
+			for (int c = cell; !(walls[c] & (1 << d)); )
+			{
+				c += offset[d];
+				// a cell nearer the goal covers the rest of the line itself
+				if (goal_distance[c] < dist)
+					break;
+				if (goal_distance[c] == UNREACHABLE)
+				{
+					goal_distance[c] = dist;
+					queue.push_back(c);
+				}
+			}
+		}
+	}
+}
+
+// The wall stop, cut short by the nearest other robot standing between
+// the robot and that stop.  Rows are contiguous runs of cell indices, so
+// for east and west any robot between the two cells is on the same row.
+int Geometry::slide(const int *robots, int count, int i, unsigned short dir) const
+{
+	int from = robots[i];
+	int to = getStop(from, dir);
+	for (int j = 0; j < count; j++)
+	{
+		int p = robots[j];
+		switch (dir)
+		{
+			case NORTH:
+				if (p % cols == from % cols && p < from && p >= to)
+					to = p + cols;
+				break;
+			case EAST:
+				if (p > from && p <= to)
+					to = p - 1;
+				break;
+			case SOUTH:
+				if (p % cols == from % cols && p > from && p <= to)
+					to = p - cols;
+				break;
+			case WEST:
+				if (p < from && p >= to)
+					to = p + 1;
+				break;
+		}
+	}
+	return to;
+}
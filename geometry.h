@@ -0,0 +1,126 @@
+#include <vector>
+
+#include "board.h"
+
+/****************************************************************
+geometry.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Precomputed wall tables shared by the fast solvers
+
+*****************************************************************/
+
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+// Directions are numbered the same way as in Board::moveRobot
+// 0 = north, 1 = east, 2 = south, 3 = west
+const unsigned short NORTH = 0;
+const unsigned short EAST = 1;
+const unsigned short SOUTH = 2;
+const unsigned short WEST = 3;
+
+// marks a cell from which the goal can never be reached
+const unsigned char UNREACHABLE = 255;
+
+// robots are named by capital letters
+const int MAX_ROBOTS = 26;
+
+// the name of a direction as printed in a solution ("north", ...)
+const char* directionName(unsigned short dir);
+
+// ==================================================================
+// The static part of a Board (dimensions, walls and the goal) turned
+// into flat tables indexed by cell.  A cell index is
+// (row - 1) * cols + (col - 1), so the corner (1,1) is cell 0.
+
+class Geometry
+{
+	public:
+		Geometry(const Board &b);
+		// Tables worked out elsewhere (see assembleGeometry in tiles.h):
+		// 'walls' and 'stops' must be what Geometry(b) would compute, and
+		// only the goal distance is computed here.
+		Geometry(const Board &b, const std::vector<unsigned char> &walls, const std::vector<int> &stops);
+
+		// ACCESSORS
+		int getRows() const
+		{
+			return rows;
+		}
+		int getCols() const
+		{
+			return cols;
+		}
+		int numCells() const
+		{
+			return rows * cols;
+		}
+		int cellIndex(const Position &p) const
+		{
+			return (p.row - 1) * cols + (p.col - 1);
+		}
+		Position cellPosition(int cell) const
+		{
+			return Position(cell / cols + 1, cell % cols + 1);
+		}
+		// the neighbouring cell in a direction (only valid if no wall is in the way)
+		int step(int cell, unsigned short dir) const
+		{
+			return cell + offset[dir];
+		}
+		// bit 'dir' is set if a wall blocks leaving the cell in that direction
+		unsigned char getWalls(int cell) const
+		{
+			return walls[cell];
+		}
+		// the cell a robot slides to from 'cell' on a board without other robots
+		int getStop(int cell, unsigned short dir) const
+		{
+			return stops[cell * 4 + dir];
+		}
+		// a lower bound on the number of moves a robot at 'cell' needs to
+		// reach the goal; UNREACHABLE if no sequence of moves gets there.
+		// Not valid after a wall change until updateGoalDistance is called.
+		unsigned char getGoalDistance(int cell) const
+		{
+			assert(!stale_goal_distance);
+			return goal_distance[cell];
+		}
+		// the goal cell, or -1 if the board has no goal
+		int getGoal() const
+		{
+			return goal;
+		}
+
+		// where robot i ends up moving in 'dir', given the cells of all
+		// 'count' robots; equal to robots[i] if the robot cannot move
+		int slide(const int *robots, int count, int i, unsigned short dir) const;
+
+		// MODIFIERS that keep the tables in step with a wall added to (or
+		// removed from) the Board, recomputing only the affected row or
+		// column of slide stops.  The goal distance is a breadth first
+		// search over every cell, so it is only marked out of date here;
+		// updateGoalDistance redoes it once for any number of edits.
+		void setHorizontalWall(double r, int c, bool present);
+		void setVerticalWall(int r, double c, bool present);
+		void updateGoalDistance();
+
+	private:
+		void computeRowStops(int r);
+		void computeColumnStops(int c);
+		void computeGoalDistance(const Position &goal);
+		void setWall(int cell, unsigned short dir, bool present);
+
+		// REPRESENTATION
+		int rows;
+		int cols;
+		int offset[4];
+		int goal;
+		std::vector<unsigned char> walls;
+		std::vector<int> stops;
+		std::vector<unsigned char> goal_distance;
+		// true if a wall changed since goal_distance was computed
+		bool stale_goal_distance;
+};
+#endif
@@ -0,0 +1,135 @@
+#include "goaltable.h"
+#include "trace.h"
+
+/****************************************************************
+goaltable.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Shortest solutions for every possible goal cell from one search
+
+*****************************************************************/
+
+
+// the starting cell of every robot
+static std::vector<int> startCells(const Board &b, const Geometry &g)
+{
+	std::vector<int> cells;
+	for (unsigned int i = 0; i < b.numRobots(); i++)
+		cells.push_back(g.cellIndex(b.getRobotPosition(i)));
+	return cells;
+}
+
+GoalTable::GoalTable(const Board &b, const Geometry &g, int max_depth)
+	: geometry(g), start_cells(startCells(b, g)), codec(g, start_cells.data(), b.numRobots(), max_depth)
+{
+	int count = b.numRobots();
+	int cells = g.numCells();
+	for (int i = 0; i < count; i++)
+		names.push_back(b.getRobot(i));
+	// index 'count' holds the table for any robot
+	moves = std::vector<std::vector<int> >(count + 1, std::vector<int>(cells, -1));
+	reached = std::vector<std::vector<StateKey> >(count + 1, std::vector<StateKey>(cells, 0));
+
+	int robots[MAX_ROBOTS];
+	for (int i = 0; i < count; i++)
+		robots[i] = g.cellIndex(b.getRobotPosition(i));
+	start = codec.pack(robots);
+	for (int i = 0; i < count; i++)
+	{
+		moves[i][robots[i]] = moves[count][robots[i]] = 0;
+		reached[i][robots[i]] = reached[count][robots[i]] = start;
+	}
+	if (!codec.fits())
+		return;
+
+	std::vector<StateKey> frontier, next;
+	frontier.push_back(start);
+	Parent root = { start, 0, 4 };
+	parents[start] = root;
+	for (int depth = 1; depth <= max_depth && !frontier.empty(); depth++)
+	{
+		TraceSpan span("layer", "depth", depth);
+		next.clear();
+		for (unsigned int k = 0; k < frontier.size(); k++)
+		{
+			codec.unpack(frontier[k], robots);
+			for (int i = 0; i < count; i++)
+			{
+				int from = robots[i];
+				for (unsigned short d = 0; d < 4; d++)
+				{
+					int to = g.slide(robots, count, i, d);
+					if (to == from)
+						continue;
+					robots[i] = to;
+					StateKey key = codec.pack(robots);
+					robots[i] = from;
+					Parent p = { frontier[k], names[i], d };
+					if (!parents.insert(std::make_pair(key, p)).second)
+						continue;
+					next.push_back(key);
+					// only the moved robot is on a new cell
+					if (moves[i][to] == -1)
+					{
+						moves[i][to] = depth;
+						reached[i][to] = key;
+					}
+					if (moves[count][to] == -1)
+					{
+						moves[count][to] = depth;
+						reached[count][to] = key;
+					}
+				}
+			}
+		}
+		frontier.swap(next);
+	}
+}
+
+int GoalTable::getMoves(int i, const Position &p) const
+{
+	if (i == -1)
+		i = names.size();
+	return moves[i][geometry.cellIndex(p)];
+}
+
+bool GoalTable::getPath(int i, const Position &p, std::vector<command> &path) const
+{
+	if (i == -1)
+		i = names.size();
+	int cell = geometry.cellIndex(p);
+	if (moves[i][cell] == -1)
+		return false;
+	// walk the search tree back to the starting positions
+	for (StateKey key = reached[i][cell]; key != start; )
+	{
+		const Parent &parent = parents.find(key)->second;
+		path.push_back(command(parent.robot, parent.dir));
+		key = parent.state;
+	}
+	return true;
+}
+
+void GoalTable::print(std::ostream &ostr) const
+{
+	for (unsigned int i = 0; i <= names.size(); i++)
+	{
+		for (int cell = 0; cell < geometry.numCells(); cell++)
+		{
+			if (moves[i][cell] == -1)
+				continue;
+			Position p = geometry.cellPosition(cell);
+			std::vector<command> path;
+			getPath(i == names.size() ? -1 : (int)i, p, path);
+			ostr << "goal ";
+			if (i == names.size())
+				ostr << "any";
+			else
+				ostr << names[i];
+			ostr << " " << p.row << " " << p.col << " " << moves[i][cell] << ":";
+			for (int m = path.size() - 1; m >= 0; m--)
+				ostr << " " << path[m].robot << " " << directionName(path[m].dir) << (m > 0 ? "," : "");
+			ostr << '\n';
+		}
+	}
+}
@@ -0,0 +1,73 @@
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "board.h"
+#include "codec.h"
+#include "command.h"
+#include "geometry.h"
+#include "solver.h"
+
+/****************************************************************
+goaltable.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Shortest solutions for every possible goal cell from one search
+
+*****************************************************************/
+
+#ifndef GOALTABLE_H
+#define GOALTABLE_H
+
+// ==================================================================
+// One breadth first search from the starting robot positions that
+// ignores the board's goal.  For every cell it records, per robot and
+// for "any" robot, the first depth at which the cell is reached, and
+// keeps the search tree so the moves can be recovered.  If the robots'
+// rest cells do not fit in a StateKey there is no search, and fits()
+// says so.
+
+class GoalTable
+{
+	public:
+		GoalTable(const Board &b, const Geometry &g, int max_depth);
+
+		// false if the robots' positions do not fit in a StateKey, in
+		// which case only the starting cells are known to be reachable
+		bool fits() const
+		{
+			return codec.fits();
+		}
+
+		// the fewest moves for robot i (-1 for any robot) to reach the
+		// cell, or -1 if it is not reachable within max_depth
+		int getMoves(int i, const Position &p) const;
+		// the moves of such a solution, appended last move first like
+		// findPath; returns false if the cell is not reachable
+		bool getPath(int i, const Position &p, std::vector<command> &path) const;
+
+		// one line per reachable (goal robot, cell) pair:
+		// goal <robot or any> <row> <col> <# of moves>: <moves>
+		void print(std::ostream &ostr) const;
+
+	private:
+		struct Parent
+		{
+			StateKey state;
+			char robot;
+			unsigned short dir;
+		};
+
+		// REPRESENTATION
+		Geometry geometry;
+		std::vector<char> names;
+		std::vector<int> start_cells;
+		StateCodec codec;
+		StateKey start;
+		// the move that first reached each state
+		std::unordered_map<StateKey, Parent> parents;
+		// per robot, then for any robot: the first depth and state reaching each cell
+		std::vector<std::vector<int> > moves;
+		std::vector<std::vector<StateKey> > reached;
+};
+#endif
@@ -5,12 +5,26 @@
 #include <fstream>
 #include "board.h"
 #include <limits>
+#include <sstream>
 
 
 //User defined and local header files
 
 #include "board.cpp"
 #include "command.h"
+#include "geometry.cpp"
+#include "codec.cpp"
+#include "frontier.cpp"
+#include "stateset.cpp"
+#include "solver.cpp"
+#include "verifier.cpp"
+#include "sessionlog.cpp"
+#include "server.cpp"
+#include "trace.cpp"
+#include "goaltable.cpp"
+#include "editor.cpp"
+#include "tablebase.cpp"
+#include "tiles.cpp"
 
 /****************************************************************
 main.cpp
@@ -24,7 +38,8 @@ March, 2020
 using namespace std;
 
 //This function is being called recursively to find out the best path of movement
-bool findPath(const Board &c, std::vector<command> &path, int depth, const command &last = command())
+//The moves are made on 'c' itself and undone again, so it is unchanged on return
+bool findPath(Board &c, std::vector<command> &path, int depth, const command &last = command())
 {
   	
   	if (depth == -1)
@@ -32,7 +47,7 @@ bool findPath(const Board &c, std::vector<command> &path, int depth, const comma
 	  
     	depth = c.getCols() * c.getRows();
     }
-  	Board temp = c;
+  	MoveUndo undo;
   	if (c.getGoalRobot() == -1)
   	{
 	  
@@ -56,17 +71,17 @@ bool findPath(const Board &c, std::vector<command> &path, int depth, const comma
         {
           	for (unsigned short d = 0; d < 4; d++)
             {
-              	temp = c;
-              
               	if (last.dir != d || last.robonum != i)
               	{
 				  
-                	if (temp.moveRobot(i, d))
+                	if (c.makeMove(i, d, undo))
                 	{
 			
                         //findPath() is a recursive function that keep on finding the right move of 
 						//the robot and positions it at appropriate place        	
-                  		if (findPath(temp, path, depth - 1, command(temp.getRobot(i), i, d))) //findPath() is being called RECURSIVELY
+                  		bool found = findPath(c, path, depth - 1, command(c.getRobot(i), i, d)); //findPath() is being called RECURSIVELY
+                  		c.unmakeMove(undo);
+                  		if (found)
                     	{
                       		path.push_back(command(c.getRobot(i), d));
                       		return true;
@@ -82,73 +97,98 @@ bool findPath(const Board &c, std::vector<command> &path, int depth, const comma
 
 
 
+// exit status when the command line cannot be used
+const int EXIT_USAGE = 1;
+// exit statuses when the puzzle file cannot be used
+const int EXIT_NO_PUZZLE = 2;
+const int EXIT_BAD_PUZZLE = 3;
+// exit status of -verify when a transcript is not a valid solution
+const int EXIT_REJECTED = 4;
+
 // This function is called if there was an error with the command line arguments
 bool usage(const std::string &executable_name)
 {
   std::cerr << "Usage: " << executable_name << " <puzzle_file>" << std::endl;
+  std::cerr << "       " << executable_name << " -serve [<# of threads>] [-trace <trace_file>]" << std::endl;
+  std::cerr << "       " << executable_name << " -scan_sessions <log_file> [-max_moves <#>]" << std::endl;
   std::cerr << "       " << executable_name << " <puzzle_file> -max_moves <#>" << std::endl;
   std::cerr << "       " << executable_name << " <puzzle_file> -all_solutions" << std::endl;
   std::cerr << "       " << executable_name << " <puzzle_file> -visualize" << std::endl;
   std::cerr << "       " << executable_name << " <puzzle_file> -max_moves <#> -all_solutions" << std::endl;
   std::cerr << "       " << executable_name << " <puzzle_file> -max_moves <#> -visualize" << std::endl;
-  exit(0);
+  std::cerr << "       " << executable_name << " <puzzle_file> -verify <transcript_file>" << std::endl;
+  std::cerr << "       " << executable_name << " <puzzle_file> -max_moves <#> -verify <transcript_file>" << std::endl;
+  std::cerr << "       " << executable_name << " <puzzle_file> -verify <transcript_file> -record <log_file>" << std::endl;
+  std::cerr << "       " << executable_name << " <puzzle_file> -max_moves <#> -all_goals" << std::endl;
+  std::cerr << "       " << executable_name << " <puzzle_file> -max_moves <#> -edit" << std::endl;
+  std::cerr << "       " << executable_name << " <puzzle_file> -max_moves <#> -threads <#>" << std::endl;
+  std::cerr << "       " << executable_name << " <puzzle_file> -build_tablebase <table_file> [-threads <#>]" << std::endl;
+  std::cerr << "       " << executable_name << " <puzzle_file> -max_moves <#> -tablebase <table_file>" << std::endl;
+  std::cerr << "       " << executable_name << " <puzzle_file> -max_moves <#> -benchmark_states" << std::endl;
+  std::cerr << "       (any of these may end with -trace <trace_file> to record a timeline)" << std::endl;
+  std::cerr << "       (a puzzle file that starts with tiles <tile_library_file> is put together from quadrant tiles)" << std::endl;
+  std::cerr << "       (exits with status 1 after printing this message, 2 if the puzzle file cannot be opened," << std::endl;
+  std::cerr << "        3 if it is malformed, and 4 if -verify rejects a transcript)" << std::endl;
+  exit(EXIT_USAGE);
+}
+
+// Read either kind of puzzle file: the plain format, or one that starts
+// "tiles <tile_library_file>" and is put together from quadrant tiles.
+// A relative library path is taken from 'directory', the puzzle file's
+// own.  For a tiled puzzle 'layout' is filled in, otherwise its first
+// tile is NULL.
+Board readPuzzle(std::istream &istr, const std::string &directory, TileLayout &layout, std::string &error)
+{
+  	layout.tiles[0] = NULL;
+  	PuzzleTokens tokens(istr);
+  	std::string first;
+  	if (!tokens.next(first) || first != "tiles")
+    {
+      	tokens.unread();
+      	return readBoard(tokens, error);
+    }
+  	std::string library_file;
+  	if (!tokens.next(library_file))
+    {
+      	error = tokens.where() + "tiles needs a tile library file";
+      	return Board(0, 0);
+    }
+  	if (library_file[0] != '/')
+    	library_file = directory + library_file;
+  	const TileLibrary *library = loadTileLibrary(library_file, error);
+  	if (library == NULL)
+    {
+      	error = tokens.where() + error;
+      	return Board(0, 0);
+    }
+  	Board b = readTiledBoard(tokens, *library, layout, error);
+  	if (!error.empty())
+    	layout.tiles[0] = NULL;
+  	return b;
 }
 
 // load a Ricochet Robots puzzle board from the input file DRAWING BOARD
-Board load(const std::string &executable, const std::string &filename)
+Board load(const std::string &filename, TileLayout &layout)
 {
+  	TraceSpan span("load");
 
   	// open the file for reading
   	std::ifstream istr(filename.c_str());
   	if (!istr)
     {
       	std::cerr << "ERROR: could not open " << filename << " for reading" << std::endl; //in case if it fails to open
-      	usage(executable);
+      	exit(EXIT_NO_PUZZLE);
     }
 
-  	// read in the board dimensions and create an empty board
-  	// (all outer edges are automatically set to be walls)
-  	int rows, cols;
-  	istr >> rows >> cols;
-  	Board answer(rows, cols);
-
-  	// read in the other characteristics of the puzzle board
-  	std::string token;
-  	while (istr >> token)
+  	// read in the board, stopping at the first malformed line
+  	std::string error;
+  	std::string::size_type slash = filename.rfind('/');
+  	std::string directory = slash == std::string::npos ? "" : filename.substr(0, slash + 1);
+  	Board answer = readPuzzle(istr, directory, layout, error);
+  	if (!error.empty())
     {
-      	if (token == "robot")
-        {
-          	char a;
-          	int r, c;
-          	istr >> a >> r >> c;
-          	answer.placeRobot(Position(r, c), a);
-        }
-      	else if (token == "vertical_wall")
-        {
-          	int i;
-          	double j;
-          	istr >> i >> j;
-          	answer.addVerticalWall(i, j);
-        }
-      	else if (token == "horizontal_wall")
-        {
-          	double i;
-          	int j;
-          	istr >> i >> j;
-          	answer.addHorizontalWall(i, j);
-        }
-      	else if (token == "goal")
-        {
-          	std::string which_robot;
-          	int r, c;
-          	istr >> which_robot >> r >> c;
-          	answer.setGoal(which_robot, Position(r, c));
-        }
-      	else
-        {
-          	std::cerr << "ERROR: unknown token in the input file " << token << std::endl;
-          	exit(0);
-        }
+      	std::cerr << "ERROR: " << filename << ", " << error << std::endl;
+      	exit(EXIT_BAD_PUZZLE);
     }
 
   	// return the initialized board
@@ -157,7 +197,8 @@ Board load(const std::string &executable, const std::string &filename)
 
 //Prototypes of functions for visualization of accessibility (Functions are defined below main()
 void printAccessibility(const vector<vector<int> > &y);
-void getAccessibility(const Board& f, vector<vector<int> > &h, unsigned int maxdepth, unsigned int curdepth = 0);
+void getAccessibility(Board& f, vector<vector<int> > &h, unsigned int maxdepth, unsigned int curdepth = 0);
+void editBoard(Editor &editor, std::istream &istr);
 
 // START-UP METHOD
 int main(int argc, char* argv[])
@@ -169,6 +210,43 @@ int main(int argc, char* argv[])
       	usage(argv[0]); //If only command if typed without any argument
     }
 
+  	// In server mode puzzles arrive on standard input instead of the command line
+  	if (argv[1] == std::string("-serve"))
+    {
+      	unsigned int threads = std::thread::hardware_concurrency();
+      	std::string trace_file;
+      	for (int arg = 2; arg < argc; arg++)
+        {
+          	if (argv[arg] == std::string("-trace") && arg + 1 < argc)
+            	trace_file = argv[++arg];
+          	else
+            	threads = atoi(argv[arg]);
+        }
+      	if (!trace_file.empty())
+        	startTracing();
+      	{
+          	Server server(threads);
+          	server.run(std::cin, std::cout);
+        }
+      	if (!trace_file.empty() && !writeTrace(trace_file))
+        	std::cerr << "ERROR: could not write " << trace_file << std::endl;
+      	return 0;
+    }
+
+  	// Statistics over a session log, which carries its own puzzles
+  	if (argv[1] == std::string("-scan_sessions"))
+    {
+      	if (argc != 3 && !(argc == 5 && argv[3] == std::string("-max_moves")))
+        	usage(argv[0]);
+      	std::ifstream log(argv[2], std::ios::binary);
+      	if (!log)
+        {
+          	std::cerr << "ERROR: could not open " << argv[2] << " for reading" << std::endl;
+          	usage(argv[0]);
+        }
+      	return scanSessions(log, argc == 5 ? atoi(argv[4]) : -1, std::cout) ? 0 : 1;
+    }
+
   	// By default, the maximum number of moves is unlimited
   	int max_moves = -1;
 
@@ -177,6 +255,34 @@ int main(int argc, char* argv[])
 
   	// By default, do not visualize the accessibility
   	bool visualize=false;
+
+  	// By default, solve the puzzle rather than check submitted solutions
+  	std::string verify_file;
+
+  	// The exit status; only -verify sets it, when a transcript is rejected
+  	int status = 0;
+
+  	// By default, the checked transcripts are not added to a session log
+  	std::string record_file;
+
+  	// By default, solve for the goal in the puzzle file only
+  	bool all_goals = false;
+
+  	// By default, search on a single thread
+  	unsigned int threads = 1;
+
+  	// By default, do not read wall edits from standard input
+  	bool edit = false;
+
+  	// By default, do not record a timeline of the solver phases
+  	std::string trace_file;
+
+  	// By default, neither build nor consult a precomputed table of solutions
+  	std::string build_tablebase_file;
+  	std::string tablebase_file;
+
+  	// By default, do not time the visited state sets
+  	bool benchmark_states = false;
 	
 	// Read in the other command line arguments
   	for (int arg = 2; arg < argc; arg++)
@@ -201,6 +307,65 @@ int main(int argc, char* argv[])
           	// steps it takes to get there
           	visualize = true;
         }
+      	else if (argv[arg] == std::string("-verify"))
+        {
+          	// the next command line arg is a file of move transcripts to check
+          	arg++;
+          	assert(arg < argc);
+          	verify_file = argv[arg];
+        }
+      	else if (argv[arg] == std::string("-record"))
+        {
+          	// the next command line arg is a session log the transcripts are appended to
+          	arg++;
+          	assert(arg < argc);
+          	record_file = argv[arg];
+        }
+      	else if (argv[arg] == std::string("-all_goals"))
+        {
+          	// find the shortest solution for every cell as the goal, in one search
+          	all_goals = true;
+        }
+      	else if (argv[arg] == std::string("-threads"))
+        {
+          	// the next command line arg is the number of threads to search with
+          	arg++;
+          	assert(arg < argc);
+          	threads = atoi(argv[arg]);
+          	assert(threads > 0);
+        }
+      	else if (argv[arg] == std::string("-edit"))
+        {
+          	// add and remove walls interactively, reporting the difficulty after each edit
+          	edit = true;
+        }
+      	else if (argv[arg] == std::string("-build_tablebase"))
+        {
+          	// the next command line arg is where the table for this board's walls is written
+          	arg++;
+          	assert(arg < argc);
+          	build_tablebase_file = argv[arg];
+        }
+      	else if (argv[arg] == std::string("-tablebase"))
+        {
+          	// the next command line arg is a table to look the solution up in
+          	arg++;
+          	assert(arg < argc);
+          	tablebase_file = argv[arg];
+        }
+      	else if (argv[arg] == std::string("-benchmark_states"))
+        {
+          	// time the search's visited set against std::unordered_set
+          	benchmark_states = true;
+        }
+      	else if (argv[arg] == std::string("-trace"))
+        {
+          	// the next command line arg is where the timeline is written
+          	arg++;
+          	assert(arg < argc);
+          	trace_file = argv[arg];
+          	startTracing();
+        }
       	else
         {
           	std::cout << "unknown command line argument " << argv[arg] << std::endl;
@@ -208,23 +373,140 @@ int main(int argc, char* argv[])
         }
     }
 
+  	// -all_goals keeps every state it reaches, and -edit searches again
+  	// after every edit, so both need a depth limit
+  	if ((all_goals || edit) && max_moves <= 0)
+    {
+      	std::cerr << "ERROR: " << (all_goals ? "-all_goals" : "-edit") << " needs -max_moves" << std::endl;
+      	usage(argv[0]);
+    }
+
   	// Load the puzzle board from the input file
-  	Board board = load(argv[0], argv[1]);
+  	TileLayout layout;
+  	Board board = load(argv[1], layout);
+
+  	// The tables every mode shares, combined from the tiles' own for a tiled puzzle
+  	Geometry geometry = layout.tiles[0] != NULL ? assembleGeometry(layout, board) : Geometry(board);
+
+  	// Checks no search should have to discover: an invalid puzzle is
+  	// rejected outright, and an unreachable goal is never searched for
+  	std::string check_error;
+  	PuzzleCheck check = checkPuzzle(board, geometry, check_error);
+  	if (check == PUZZLE_INVALID)
+    {
+      	std::cerr << "ERROR: " << argv[1] << ", " << check_error << std::endl;
+      	exit(EXIT_BAD_PUZZLE);
+    }
+  	bool unsolvable = check == PUZZLE_UNSOLVABLE;
 
   
-  	if (!visualize)
+  	if (!verify_file.empty())
+    {
+      	std::ifstream transcripts(verify_file.c_str());
+      	if (!transcripts)
+        {
+          	std::cerr << "ERROR: could not open " << verify_file << " for reading" << std::endl;
+          	usage(argv[0]);
+        }
+      	TraceSpan span("verify");
+      	//The optimal length is found once and compared against every transcript
+      	int optimal = unsolvable ? -1 : shortestSolution(board, geometry, max_moves > 0 ? max_moves : board.getRows() * board.getCols());
+      	SessionWriter log;
+      	std::string error;
+      	if (!record_file.empty() && !log.open(record_file, error))
+        {
+          	std::cerr << "ERROR: " << error << std::endl;
+          	usage(argv[0]);
+        }
+      	if (verifyTranscripts(board, optimal, transcripts, std::cout, record_file.empty() ? NULL : &log) > 0)
+          	status = EXIT_REJECTED;
+      	if (!record_file.empty() && !log.flush())
+          	std::cerr << "ERROR: could not write " << record_file << std::endl;
+    }
+  	else if (!build_tablebase_file.empty())
+    {
+      	TraceSpan span("tablebase");
+      	std::string error;
+      	if (!buildTablebase(board, geometry, threads, build_tablebase_file, error))
+        {
+          	std::cerr << "ERROR: " << error << std::endl;
+          	exit(1);
+        }
+    }
+  	else if (benchmark_states)
+    {
+      	TraceSpan span("benchmark");
+      	benchmarkStateSets(board, geometry, max_moves > 0 ? max_moves : board.getRows() * board.getCols(), std::cout);
+    }
+  	else if (edit)
+    {
+      	Editor editor(board, max_moves);
+      	editBoard(editor, std::cin);
+    }
+  	else if (all_goals)
+    {
+      	GoalTable table(board, geometry, max_moves);
+      	if (!table.fits())
+        {
+          	std::cerr << "ERROR: the robots' positions do not fit in a StateKey" << std::endl;
+          	exit(1);
+        }
+      	TraceSpan span("output");
+      	table.print(std::cout);
+    }
+  	else if (!visualize)
     {
       	
       	vector<struct command> d; //struct command is an user defined structure in command.h
       	board.print();
-      	int mx;
-      	//Finding a shorter solution than specified, if only because the algorithm still lacks proper handling for the correct behavior.
-      	for (mx = max_moves - 2; d.empty() && mx <= max_moves; mx++)
+      	int moves;
+      	//A precomputed table answers instantly, if it was built for these walls and covers this position
+      	Tablebase table;
+      	bool from_table = false;
+      	if (!tablebase_file.empty() && !unsolvable)
+        {
+          	TraceSpan span("tablebase");
+          	std::string error;
+          	if (!table.open(tablebase_file, error))
+            	std::cerr << "WARNING: " << error << std::endl;
+          	else
+            	from_table = table.solve(board, geometry, d) && (max_moves <= 0 || (int)d.size() <= max_moves);
+          	if (!from_table)
+            	d.clear();
+        }
+      	//Use the solver compiled for this board size and robot count if there is one
+      	SolveFunction solver = findSolver(board);
+      	//With several threads the generic search is used rather than findPath, since only it can be split up
+      	if (solver == NULL && threads > 1 && board.getGoal().row != -1)
+        	solver = &solveGeneric;
+      	if (unsolvable)
+        {
+          	//checkPuzzle found the goal out of reach, so there is nothing to search for
+          	moves = 0;
+        }
+      	else if (from_table)
         {
-          	findPath(board, d, mx); //Calling findPath() that will be processed recursively
+          	moves = d.size();
+        }
+      	else if (solver != NULL)
+        {
+          	solver(board, geometry, max_moves > 0 ? max_moves : board.getRows() * board.getCols(), threads, d);
+          	moves = d.size();
+        }
+      	else
+        {
+          	int mx;
+          	//Finding a shorter solution than specified, if only because the algorithm still lacks proper handling for the correct behavior.
+          	for (mx = max_moves - 2; d.empty() && mx <= max_moves; mx++)
+            {
+              	TraceSpan span("depth", "max_moves", mx);
+              	findPath(board, d, mx); //Calling findPath() that will be processed recursively
+            }
+          	moves = mx - 1;
         }
       	if (!d.empty())
         {
+          	TraceSpan span("output");
           	for (int i = d.size() - 1; i >= 0; i--)
             {
 
@@ -260,7 +542,7 @@ int main(int argc, char* argv[])
                   	break;
                 }
             }
-          	cout << " reaches the goal after " << mx - 1 << " moves" << endl;
+          	cout << " reaches the goal after " << moves << " moves" << endl;
         }
       	else
         {
@@ -269,13 +551,20 @@ int main(int argc, char* argv[])
     }
   	else
     {
+      	TraceSpan span("visualize");
       	vector<vector<int> > itz;
       	getAccessibility(board, itz, max_moves, 0);
       	printAccessibility(itz);
     }
 
+  	if (!trace_file.empty() && !writeTrace(trace_file))
+    {
+      	std::cerr << "ERROR: could not write " << trace_file << std::endl;
+    }
+  	return status;
 }
-void getAccessibility(const Board& f, vector<vector<int> > &h, unsigned int maxdepth, unsigned int curdepth)
+//Like findPath, the moves are made on 'f' and undone again
+void getAccessibility(Board& f, vector<vector<int> > &h, unsigned int maxdepth, unsigned int curdepth)
 {
   	//Initialize the vector to the correct size
   	if (curdepth == 0)
@@ -299,19 +588,19 @@ void getAccessibility(const Board& f, vector<vector<int> > &h, unsigned int maxd
 
           	for (unsigned short c = 0; c < 4; c++)
             {  
-				//copy to a temporary variable
-               	//needs to happen in order to explore the movement spaces of the robots properly
-              	Board temp = f;
-              	Position curbot = temp.getRobotPosition(g);
+              	Position curbot = f.getRobotPosition(g);
               	
               	if (h[curbot.row - 1][curbot.col - 1] > curdepth)
               	{
 				    h[curbot.row - 1][curbot.col - 1] = curdepth;
                 }
-              	if (temp.moveRobot(g, c))
+              	//the move is undone afterwards, so every direction starts from the same board
+              	MoveUndo undo;
+              	if (f.makeMove(g, c, undo))
                 {
-                  	getAccessibility(temp, h, maxdepth, curdepth + 1);
+                  	getAccessibility(f, h, maxdepth, curdepth + 1);
                   //if the position is found with a smaller number of turns, then this is nice.
+                  	f.unmakeMove(undo);
                 }
             }
         }
@@ -334,6 +623,62 @@ void getAccessibility(const Board& f, vector<vector<int> > &h, unsigned int maxd
     }
 
 }
+// Read wall edits, one per line, until the end of input:
+//     add horizontal_wall <row> <col>      remove horizontal_wall <row> <col>
+//     add vertical_wall <row> <col>        remove vertical_wall <row> <col>
+//     print
+//     map
+// After every edit the difficulty is printed; map prints the
+// accessibility map, which takes a search of every state within the
+// move limit, so only on request.
+void editBoard(Editor &editor, std::istream &istr)
+{
+  	std::string line;
+  	while (std::getline(istr, line))
+    {
+      	// the numbers are read as strictly as the puzzle file's own
+      	std::istringstream words(line);
+      	PuzzleTokens tokens(words);
+      	std::string action, wall, extra;
+      	if (!tokens.next(action))
+        	continue;
+      	if (action == "print")
+        {
+          	Board b = editor.getBoard();
+          	b.print();
+          	continue;
+        }
+      	if (action == "map")
+        {
+          	if (editor.getAccessibility().empty())
+            	cout << "cannot map: the robots' positions do not fit in a StateKey" << endl;
+          	else
+            	printAccessibility(editor.getAccessibility());
+          	continue;
+        }
+      	int i, j;
+      	bool done = false;
+      	if ((action == "add" || action == "remove") && tokens.next(wall))
+        {
+          	TraceSpan span("edit");
+          	if (wall == "horizontal_wall" && tokens.nextHalf(i) && tokens.nextInt(j) && !tokens.next(extra))
+            	done = action == "add" ? editor.addHorizontalWall(i, j) : editor.removeHorizontalWall(i, j);
+          	else if (wall == "vertical_wall" && tokens.nextInt(i) && tokens.nextHalf(j) && !tokens.next(extra))
+            	done = action == "add" ? editor.addVerticalWall(i, j) : editor.removeVerticalWall(i, j);
+        }
+      	if (!done)
+        {
+          	cout << "cannot " << line << endl;
+          	continue;
+        }
+      	int moves = editor.getDifficulty();
+      	if (moves >= 0)
+        	cout << "difficulty " << moves << " moves" << endl;
+      	else
+        	cout << "no solution within the move limit" << endl;
+    }
+}
+
 void printAccessibility(const vector<vector<int> > &y)
 {
   	for (unsigned int c = 0; c < y.size(); c++)
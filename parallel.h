@@ -0,0 +1,276 @@
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "command.h"
+#include "geometry.h"
+#include "trace.h"
+
+/****************************************************************
+parallel.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Depth limited search split across threads by work stealing
+
+*****************************************************************/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// the first moves of the search tree are handed out as separate tasks,
+// deeper levels are searched by one thread with Solver::search
+const unsigned int SPLIT_DEPTH = 3;
+// passes shallower than this finish faster than threads start
+const int SERIAL_DEPTH = 5;
+
+// ==================================================================
+// One depth limited pass of a FixedSolver or GenericSolver, shared by
+// several threads.  Every worker has its own deque of tasks (a position
+// and the moves leading to it).  A worker splits a task near the root
+// into one task per move, pushes them on its own deque and keeps taking
+// the newest; idle workers steal the oldest tasks from the others,
+// which are the largest unexplored sibling subtrees.
+//
+// Moves are ordered by robot then direction, the order the serial
+// search tries them in, and the pass reports the first solution in that
+// order, so the answer is the same as the serial search no matter how
+// the work was divided.  When a solution is found, workers busy with
+// tasks that come after it in that order are told to stop.
+
+template <class Solver>
+class ParallelSearch
+{
+	public:
+		ParallelSearch(const Solver &s, unsigned int num_threads);
+
+		// like Solver::search(depth, -1, 4, path) from the starting position
+		bool search(int depth, std::vector<command> &path);
+
+	private:
+		// a move is stored as robot * 4 + direction
+		typedef std::vector<unsigned char> Moves;
+
+		struct Task
+		{
+			Moves moves;
+			int robots[MAX_ROBOTS];
+		};
+		struct Worker
+		{
+			Worker(const Solver &s) : solver(s), stop(false)
+			{
+			}
+			Solver solver;
+			std::mutex lock;
+			std::deque<Task> tasks;
+			std::atomic<bool> stop;
+			// the moves of the task being worked on, guarded by best_lock
+			Moves current;
+		};
+
+		void work(unsigned int w);
+		void run(Worker &worker, const Task &task);
+		bool take(unsigned int w, Task &task);
+		void record(const Moves &moves);
+		static bool after(const Moves &a, const Moves &b);
+
+		// REPRESENTATION
+		Solver prototype;
+		std::vector<std::unique_ptr<Worker> > workers;
+		int depth;
+		// tasks queued or running; the pass is over when it reaches 0
+		std::atomic<int> outstanding;
+		// the first solution found so far in move order
+		std::mutex best_lock;
+		bool found;
+		Moves best;
+};
+
+
+// true if a comes after b in move order, but is not part of b's path
+template <class Solver>
+bool ParallelSearch<Solver>::after(const Moves &a, const Moves &b)
+{
+	for (unsigned int i = 0; i < a.size() && i < b.size(); i++)
+	{
+		if (a[i] != b[i])
+			return a[i] > b[i];
+	}
+	return false;
+}
+
+template <class Solver>
+ParallelSearch<Solver>::ParallelSearch(const Solver &s, unsigned int num_threads) : prototype(s), outstanding(0), found(false)
+{
+	for (unsigned int i = 0; i < num_threads; i++)
+		workers.push_back(std::unique_ptr<Worker>(new Worker(s)));
+}
+
+template <class Solver>
+bool ParallelSearch<Solver>::search(int d, std::vector<command> &path)
+{
+	depth = d;
+	found = false;
+	best.clear();
+	Task root;
+	prototype.getRobots(root.robots);
+	workers[0]->tasks.push_back(root);
+	outstanding = 1;
+
+	std::vector<std::thread> threads;
+	for (unsigned int w = 0; w < workers.size(); w++)
+		threads.push_back(std::thread(&ParallelSearch::work, this, w));
+	for (unsigned int w = 0; w < threads.size(); w++)
+		threads[w].join();
+
+	if (!found)
+		return false;
+	// like the serial search, the path is stored last move first
+	for (int i = best.size() - 1; i >= 0; i--)
+		path.push_back(command(prototype.getRobot(best[i] / 4), best[i] / 4, best[i] % 4));
+	return true;
+}
+
+// take the newest task from our own deque, or steal the oldest from another worker
+template <class Solver>
+bool ParallelSearch<Solver>::take(unsigned int w, Task &task)
+{
+	for (unsigned int k = 0; k < workers.size(); k++)
+	{
+		Worker &victim = *workers[(w + k) % workers.size()];
+		std::lock_guard<std::mutex> lock(victim.lock);
+		if (victim.tasks.empty())
+			continue;
+		if (k == 0)
+		{
+			task = victim.tasks.back();
+			victim.tasks.pop_back();
+		}
+		else
+		{
+			task = victim.tasks.front();
+			victim.tasks.pop_front();
+		}
+		return true;
+	}
+	return false;
+}
+
+template <class Solver>
+void ParallelSearch<Solver>::work(unsigned int w)
+{
+	TraceSpan span("worker", "depth", depth);
+	Worker &worker = *workers[w];
+	Task task;
+	while (true)
+	{
+		if (!take(w, task))
+		{
+			if (outstanding.load() == 0)
+				return;
+			std::this_thread::yield();
+			continue;
+		}
+		run(worker, task);
+		outstanding.fetch_sub(1);
+	}
+}
+
+template <class Solver>
+void ParallelSearch<Solver>::run(Worker &worker, const Task &task)
+{
+	{
+		std::lock_guard<std::mutex> lock(best_lock);
+		if (found && after(task.moves, best))
+			return;
+		worker.current = task.moves;
+		worker.stop = false;
+	}
+
+	Solver &solver = worker.solver;
+	solver.setRobots(task.robots);
+	int remaining = depth - task.moves.size();
+	int last_robot = task.moves.empty() ? -1 : task.moves.back() / 4;
+	unsigned short last_dir = task.moves.empty() ? 4 : task.moves.back() % 4;
+
+	if (task.moves.size() >= SPLIT_DEPTH || remaining <= 0)
+	{
+		std::vector<command> tail;
+		if (solver.search(remaining, last_robot, last_dir, tail, &worker.stop))
+		{
+			Moves moves = task.moves;
+			for (int i = tail.size() - 1; i >= 0; i--)
+				moves.push_back(tail[i].robonum * 4 + tail[i].dir);
+			record(moves);
+		}
+		return;
+	}
+
+	// split: the same checks as the top of Solver::search, then one task per move
+	if (solver.atGoal())
+	{
+		record(task.moves);
+		return;
+	}
+	if (solver.lowerBound() > remaining)
+		return;
+	std::vector<Task> children;
+	for (int i = 0; i < solver.numRobots(); i++)
+	{
+		for (unsigned short d = 0; d < 4; d++)
+		{
+			if (i == last_robot && d == last_dir)
+				continue;
+			Task child;
+			solver.getRobots(child.robots);
+			int to = solver.slide(i, d);
+			if (to == child.robots[i])
+				continue;
+			child.robots[i] = to;
+			child.moves = task.moves;
+			child.moves.push_back(i * 4 + d);
+			children.push_back(child);
+		}
+	}
+	outstanding.fetch_add(children.size());
+	std::lock_guard<std::mutex> lock(worker.lock);
+	// newest at the back, so the first move in order is taken next
+	for (int k = children.size() - 1; k >= 0; k--)
+		worker.tasks.push_back(children[k]);
+}
+
+template <class Solver>
+void ParallelSearch<Solver>::record(const Moves &moves)
+{
+	std::lock_guard<std::mutex> lock(best_lock);
+	if (found && !(moves < best))
+		return;
+	found = true;
+	best = moves;
+	for (unsigned int w = 0; w < workers.size(); w++)
+	{
+		if (after(workers[w]->current, best))
+			workers[w]->stop = true;
+	}
+}
+
+
+// Iterative deepening like Solver::solve, with every pass from
+// SERIAL_DEPTH on split across the threads.
+template <class Solver>
+bool solveParallel(const Solver &solver, int max_depth, unsigned int threads, std::vector<command> &path)
+{
+	Solver serial = solver;
+	ParallelSearch<Solver> parallel(solver, threads);
+	for (int depth = 0; depth <= max_depth; depth++)
+	{
+		TraceSpan span("depth", "depth", depth);
+		if (depth < SERIAL_DEPTH ? serial.search(depth, -1, 4, path) : parallel.search(depth, path))
+			return true;
+	}
+	return false;
+}
+#endif
@@ -0,0 +1,214 @@
+#include <sstream>
+
+#include "server.h"
+#include "solver.h"
+#include "trace.h"
+
+/****************************************************************
+server.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Long running solver answering requests over a line protocol
+
+*****************************************************************/
+
+
+// the most board cells whose Geometry is cached; at about 18 bytes of
+// tables a cell this holds a few hundred megabytes
+const unsigned long long MAX_CACHED_CELLS = 1 << 24;
+
+Server::Server(unsigned int num_threads) : output(NULL), closed(false), cached_cells(0)
+{
+	if (num_threads == 0)
+		num_threads = 1;
+	for (unsigned int i = 0; i < num_threads; i++)
+		threads.push_back(std::thread(&Server::worker, this));
+}
+
+Server::~Server()
+{
+	{
+		std::lock_guard<std::mutex> lock(queue_lock);
+		closed = true;
+	}
+	queue_ready.notify_all();
+	for (unsigned int i = 0; i < threads.size(); i++)
+	{
+		if (threads[i].joinable())
+			threads[i].join();
+	}
+}
+
+void Server::run(std::istream &istr, std::ostream &ostr)
+{
+	output = &ostr;
+	std::string line;
+	while (std::getline(istr, line))
+	{
+		std::istringstream words(line);
+		std::string token;
+		if (!(words >> token))
+			continue;
+
+		Request request;
+		request.max_moves = -1;
+		if (token != "solve" || !(words >> request.id))
+		{
+			std::lock_guard<std::mutex> lock(output_lock);
+			ostr << "error - expected solve <id>, not " << line << std::endl;
+			continue;
+		}
+		while (words >> token)
+		{
+			if (token == "max_moves")
+				words >> request.max_moves;
+		}
+
+		// the puzzle runs up to the "end" line
+		while (std::getline(istr, line))
+		{
+			std::istringstream first(line);
+			std::string keyword;
+			first >> keyword;
+			if (keyword == "end")
+				break;
+			request.puzzle += line;
+			request.puzzle += '\n';
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(queue_lock);
+			queue.push_back(request);
+		}
+		queue_ready.notify_one();
+	}
+
+	// let the workers finish what is queued, then stop them
+	{
+		std::lock_guard<std::mutex> lock(queue_lock);
+		closed = true;
+	}
+	queue_ready.notify_all();
+	for (unsigned int i = 0; i < threads.size(); i++)
+		threads[i].join();
+}
+
+void Server::worker()
+{
+	while (true)
+	{
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(queue_lock);
+			while (queue.empty() && !closed)
+				queue_ready.wait(lock);
+			if (queue.empty())
+				return;
+			request = queue.front();
+			queue.pop_front();
+		}
+
+		std::string response = handle(request);
+		std::lock_guard<std::mutex> lock(output_lock);
+		*output << response << std::flush;
+	}
+}
+
+// the parsed board written out without its robot lines, so boards that
+// differ only in where the robots start share a key
+static std::string geometryKey(const Board &b)
+{
+	std::ostringstream board_text;
+	writeBoard(board_text, b);
+	std::istringstream lines(board_text.str());
+	std::string key, line;
+	while (std::getline(lines, line))
+	{
+		if (line.compare(0, 6, "robot ") != 0)
+		{
+			key += line;
+			key += '\n';
+		}
+	}
+	return key;
+}
+
+std::shared_ptr<const Geometry> Server::geometryFor(const Board &b)
+{
+	std::string key = geometryKey(b);
+	{
+		std::lock_guard<std::mutex> lock(geometry_lock);
+		std::map<std::string, CachedGeometry>::iterator itr = geometries.find(key);
+		if (itr != geometries.end())
+		{
+			recent.splice(recent.begin(), recent, itr->second.age);
+			return itr->second.geometry;
+		}
+	}
+	// build it outside the lock; if two threads race the first one wins
+	std::shared_ptr<const Geometry> g(new Geometry(b));
+	unsigned long long cells = g->numCells();
+	if (cells > MAX_CACHED_CELLS)
+		return g;
+	std::lock_guard<std::mutex> lock(geometry_lock);
+	std::pair<std::map<std::string, CachedGeometry>::iterator, bool> added = geometries.insert(std::make_pair(key, CachedGeometry()));
+	if (!added.second)
+		return added.first->second.geometry;
+	// make room by dropping the least recently used
+	while (cached_cells + cells > MAX_CACHED_CELLS)
+	{
+		std::map<std::string, CachedGeometry>::iterator oldest = geometries.find(*recent.back());
+		cached_cells -= oldest->second.geometry->numCells();
+		recent.pop_back();
+		geometries.erase(oldest);
+	}
+	added.first->second.geometry = g;
+	added.first->second.age = recent.insert(recent.begin(), &added.first->first);
+	cached_cells += cells;
+	return g;
+}
+
+std::string Server::handle(const Request &request)
+{
+	TraceSpan span("request");
+	std::ostringstream ostr;
+	std::istringstream puzzle(request.puzzle);
+	std::string error;
+	Board board = readBoard(puzzle, error);
+	if (error.empty() && board.getGoal().row == -1)
+		error = "the puzzle has no goal";
+	if (!error.empty())
+	{
+		ostr << "error " << request.id << " " << error << '\n';
+		return ostr.str();
+	}
+
+	std::shared_ptr<const Geometry> g = geometryFor(board);
+	// a goal the goal robot can never reach is answered without searching
+	PuzzleCheck check = checkPuzzle(board, *g, error);
+	if (check == PUZZLE_INVALID)
+	{
+		ostr << "error " << request.id << " " << error << '\n';
+		return ostr.str();
+	}
+	if (check == PUZZLE_UNSOLVABLE)
+	{
+		ostr << "no_solution " << request.id << '\n';
+		return ostr.str();
+	}
+	int max_moves = request.max_moves > 0 ? request.max_moves : board.getRows() * board.getCols();
+	std::vector<command> path;
+	SolveFunction solver = findSolver(board);
+	// the pool already keeps every thread busy, so each request is solved by one thread
+	bool found = solver != NULL ? solver(board, *g, max_moves, 1, path) : solveGeneric(board, *g, max_moves, 1, path);
+	if (!found)
+	{
+		ostr << "no_solution " << request.id << '\n';
+		return ostr.str();
+	}
+	ostr << "solution " << request.id << " " << path.size() << '\n';
+	for (int i = path.size() - 1; i >= 0; i--)
+		ostr << "Robot " << path[i].robot << " moves " << directionName(path[i].dir) << '\n';
+	ostr << "end" << '\n';
+	return ostr.str();
+}
@@ -0,0 +1,95 @@
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "geometry.h"
+
+/****************************************************************
+server.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Long running solver answering requests over a line protocol
+
+*****************************************************************/
+
+#ifndef SERVER_H
+#define SERVER_H
+
+// ==================================================================
+// Reads requests from one stream and writes responses to another,
+// keeping a pool of solver threads and the Geometry of every board it
+// has seen between requests.  A request is
+//
+//     solve <id> [max_moves <#>]
+//     <the puzzle, in the puzzle file format>
+//     end
+//
+// and the response is either
+//
+//     solution <id> <# of moves>
+//     Robot A moves north
+//     ...
+//     end
+//
+// or a single line "no_solution <id>" or "error <id> <message>".
+// Requests are solved in parallel, so responses may not come back in
+// the order the requests were sent; the id ties them together.
+
+class Server
+{
+	public:
+		Server(unsigned int num_threads);
+		~Server();
+
+		// serve requests until the end of istr, then wait for every
+		// outstanding response to be written
+		void run(std::istream &istr, std::ostream &ostr);
+
+	private:
+		struct Request
+		{
+			std::string id;
+			int max_moves;
+			std::string puzzle;
+		};
+		struct CachedGeometry
+		{
+			std::shared_ptr<const Geometry> geometry;
+			// this entry's place in recent
+			std::list<const std::string*>::iterator age;
+		};
+
+		void worker();
+		std::string handle(const Request &request);
+		std::shared_ptr<const Geometry> geometryFor(const Board &b);
+
+		// REPRESENTATION
+		std::vector<std::thread> threads;
+		std::ostream *output;
+		std::mutex output_lock;
+
+		// requests waiting for a solver thread
+		std::deque<Request> queue;
+		bool closed;
+		std::mutex queue_lock;
+		std::condition_variable queue_ready;
+
+		// Geometry of previously seen boards, by the board written out
+		// without its robots, which is all the Geometry depends on.  The
+		// least recently used are dropped to keep the total cells within
+		// MAX_CACHED_CELLS.
+		std::map<std::string, CachedGeometry> geometries;
+		// the keys of geometries, most recently used first
+		std::list<const std::string*> recent;
+		unsigned long long cached_cells;
+		std::mutex geometry_lock;
+};
+#endif
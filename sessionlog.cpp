@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "sessionlog.h"
+#include "geometry.h"
+#include "solver.h"
+#include "trace.h"
+#include "verifier.h"
+
+/****************************************************************
+sessionlog.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Binary log of played games, with replay and statistics
+
+*****************************************************************/
+
+
+const char SESSION_MAGIC[4] = { 'R', 'R', 'S', 'L' };
+const unsigned char SESSION_VERSION = 1;
+// the reader's block size
+const size_t SESSION_BUFFER = 1 << 20;
+// how many times, 10 ms apart, a writer looks for the header of a log
+// another writer has just created
+const int SESSION_HEADER_WAITS = 100;
+// the longest puzzle text writeBoard can produce: no line is longer than
+// 32 bytes, and besides the walls there are at most 28 lines
+const unsigned long long MAX_SESSION_PUZZLE = 32ULL * (2ULL * MAX_BOARD_SIDE * MAX_BOARD_SIDE + 28);
+
+// FNV-1a of the puzzle text
+static unsigned long long puzzleId(const std::string &text)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	for (unsigned int i = 0; i < text.size(); i++)
+	{
+		hash ^= (unsigned char)text[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static void writeNumber(std::string &out, unsigned long long value, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+		out += (char)(value >> (8 * i));
+}
+
+static unsigned long long readNumber(const unsigned char *data, int bytes)
+{
+	unsigned long long value = 0;
+	for (int i = bytes - 1; i >= 0; i--)
+		value = (value << 8) | data[i];
+	return value;
+}
+
+
+// ==================================================================
+// SessionWriter
+
+SessionWriter::SessionWriter() : fd(-1), failed(false)
+{
+}
+
+SessionWriter::~SessionWriter()
+{
+	if (fd >= 0)
+	{
+		flush();
+		close(fd);
+	}
+}
+
+bool SessionWriter::open(const std::string &filename, std::string &error)
+{
+	// Only the writer that creates the file writes its header, before any
+	// other writer can append.  Any other writer waits briefly for the
+	// header, in case the file has only just been created, and never
+	// writes one itself.
+	fd = ::open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_EXCL, 0644);
+	if (fd >= 0)
+	{
+		std::string header(SESSION_MAGIC, 4);
+		header += (char)SESSION_VERSION;
+		if (write(fd, header.data(), header.size()) != (ssize_t)header.size())
+		{
+			error = "could not write " + filename;
+			close(fd);
+			fd = -1;
+			unlink(filename.c_str());
+			return false;
+		}
+		return true;
+	}
+	fd = ::open(filename.c_str(), O_WRONLY | O_APPEND);
+	if (fd < 0)
+	{
+		error = "could not open " + filename + " for writing";
+		return false;
+	}
+	for (int attempt = 0; attempt < SESSION_HEADER_WAITS; attempt++)
+	{
+		char magic[4];
+		std::ifstream probe(filename.c_str(), std::ios::binary);
+		if (probe.read(magic, 4) && memcmp(magic, SESSION_MAGIC, 4) == 0)
+			return true;
+		if (probe.gcount() == 4)
+			break;
+		usleep(10000);
+	}
+	error = filename + " is not a session log";
+	close(fd);
+	fd = -1;
+	return false;
+}
+
+void SessionWriter::startSession(const Board &b)
+{
+	flush();
+	std::ostringstream text;
+	writeBoard(text, b);
+	unsigned long long id = puzzleId(text.str());
+	if (puzzles.insert(id).second)
+	{
+		pending += (char)SESSION_PUZZLE;
+		writeNumber(pending, id, 8);
+		writeNumber(pending, text.str().size(), 4);
+		pending += text.str();
+	}
+	pending += (char)SESSION_START;
+	writeNumber(pending, id, 8);
+
+	robot_id = std::vector<int>(MAX_ROBOTS, -1);
+	for (unsigned int i = 0; i < b.numRobots(); i++)
+		robot_id[b.getRobot(i) - 'A'] = i;
+}
+
+bool SessionWriter::addMove(const command &c)
+{
+	if (robot_id.empty() || c.dir > 3)
+		return false;
+	int i = SESSION_NO_ROBOT;
+	if (c.robot >= 'A' && c.robot <= 'Z' && robot_id[c.robot - 'A'] != -1)
+		i = robot_id[c.robot - 'A'];
+	pending += (char)(i * 4 + c.dir);
+	return true;
+}
+
+// A short write is not retried: finishing it with a second write could
+// put another writer's session in the middle of this one.
+bool SessionWriter::flush()
+{
+	if (!pending.empty())
+	{
+		if (fd < 0 || write(fd, pending.data(), pending.size()) != (ssize_t)pending.size())
+			failed = true;
+		pending.clear();
+	}
+	return !failed;
+}
+
+
+// ==================================================================
+// SessionReader
+
+SessionReader::SessionReader(std::istream &i) : istr(i), buffer(SESSION_BUFFER), pos(0), end(0), puzzle_id(0), board(NULL)
+{
+	char magic[5];
+	if (!read(magic, 5) || memcmp(magic, SESSION_MAGIC, 4) != 0)
+		error = "not a session log";
+	else if ((unsigned char)magic[4] != SESSION_VERSION)
+		error = "unsupported session log version";
+}
+
+// make sure there is at least one unread byte in the buffer
+bool SessionReader::fill()
+{
+	if (pos < end)
+		return true;
+	istr.read(&buffer[0], buffer.size());
+	pos = 0;
+	end = istr.gcount();
+	return end > 0;
+}
+
+bool SessionReader::read(void *data, size_t length)
+{
+	char *out = (char*)data;
+	while (length > 0)
+	{
+		if (!fill())
+			return false;
+		size_t n = std::min(length, end - pos);
+		memcpy(out, &buffer[pos], n);
+		pos += n;
+		out += n;
+		length -= n;
+	}
+	return true;
+}
+
+bool SessionReader::nextSession()
+{
+	while (error.empty() && fill())
+	{
+		unsigned char tag = buffer[pos++];
+		if (tag < SESSION_PUZZLE)
+		{
+			// what is left of the current session
+			if (board == NULL)
+				error = "move before the first session";
+			continue;
+		}
+		unsigned char number[12];
+		if (tag == SESSION_PUZZLE)
+		{
+			if (!read(number, 12))
+			{
+				error = "truncated puzzle record";
+				break;
+			}
+			unsigned long long id = readNumber(number, 8);
+			unsigned long long length = readNumber(number + 8, 4);
+			if (length > MAX_SESSION_PUZZLE)
+			{
+				error = "puzzle record too long";
+				break;
+			}
+			// grown a block at a time, so a damaged length costs no more
+			// memory than the file has bytes
+			std::string text;
+			while (text.size() < length && fill())
+			{
+				size_t n = std::min((size_t)(length - text.size()), end - pos);
+				text.append(&buffer[pos], n);
+				pos += n;
+			}
+			if (text.size() < length)
+			{
+				error = "truncated puzzle record";
+				break;
+			}
+			if (boards.find(id) != boards.end())
+				continue;
+			std::istringstream puzzle(text);
+			Board b = readBoard(puzzle, error);
+			if (!error.empty())
+			{
+				error = "bad puzzle record: " + error;
+				break;
+			}
+			boards.insert(std::make_pair(id, b));
+		}
+		else if (tag == SESSION_START)
+		{
+			if (!read(number, 8))
+			{
+				error = "truncated session record";
+				break;
+			}
+			puzzle_id = readNumber(number, 8);
+			std::map<unsigned long long, Board>::const_iterator p = boards.find(puzzle_id);
+			if (p == boards.end())
+			{
+				error = "session of a puzzle that is not in the log";
+				break;
+			}
+			board = &p->second;
+			return true;
+		}
+		else
+			error = "unknown record";
+	}
+	return false;
+}
+
+bool SessionReader::nextMove(command &c)
+{
+	if (board == NULL || !fill())
+		return false;
+	unsigned char move = buffer[pos];
+	if (move >= SESSION_PUZZLE)
+		return false;
+	pos++;
+	unsigned int i = move / 4;
+	c = command(i < board->numRobots() ? board->getRobot(i) : '?', i, move % 4);
+	return true;
+}
+
+
+// ==================================================================
+// Statistics
+
+// what the scan keeps for each puzzle
+struct ScannedPuzzle
+{
+	ScannedPuzzle(const Board &b, int max_depth)
+		: verifier(b), optimal(shortestSolution(b, Geometry(b), max_depth > 0 ? max_depth : b.getRows() * b.getCols()))
+	{
+	}
+	Verifier verifier;
+	int optimal;
+};
+
+bool scanSessions(std::istream &istr, int max_depth, std::ostream &ostr)
+{
+	TraceSpan span("scan");
+	SessionReader reader(istr);
+	std::map<unsigned long long, ScannedPuzzle> puzzles;
+	unsigned long sessions = 0, total_moves = 0, solved = 0, optimal_count = 0, unsolved = 0, illegal = 0, measured = 0;
+	long long excess = 0;
+	while (reader.nextSession())
+	{
+		std::map<unsigned long long, ScannedPuzzle>::iterator p = puzzles.find(reader.getPuzzleId());
+		if (p == puzzles.end())
+			p = puzzles.insert(std::make_pair(reader.getPuzzleId(), ScannedPuzzle(reader.getBoard(), max_depth))).first;
+		Verifier &v = p->second.verifier;
+		v.restart();
+		// like verifyTranscripts, moves after the goal is reached are illegal
+		bool legal = true;
+		command c;
+		while (reader.nextMove(c))
+		{
+			total_moves++;
+			if (legal && (v.solved() || !v.apply(c)))
+				legal = false;
+		}
+		sessions++;
+		if (!legal)
+			illegal++;
+		else if (!v.solved())
+			unsolved++;
+		else
+		{
+			solved++;
+			int optimal = p->second.optimal;
+			if (optimal >= 0)
+			{
+				measured++;
+				excess += v.numMoves() - optimal;
+				if (v.numMoves() == optimal)
+					optimal_count++;
+			}
+		}
+	}
+	if (!reader.getError().empty())
+	{
+		ostr << "error after " << sessions << " sessions: " << reader.getError() << '\n';
+		return false;
+	}
+
+	ostr << "scanned " << sessions << " sessions of " << puzzles.size() << " puzzles with " << total_moves << " moves: "
+	     << solved << " solved (" << optimal_count << " optimal), "
+	     << unsolved << " unsolved, " << illegal << " illegal" << '\n';
+	if (measured > 0)
+		ostr << "average " << (double)excess / measured << " moves over optimal in " << measured << " solved sessions" << '\n';
+	else
+		ostr << "no solved sessions of a puzzle with a known optimal solution" << '\n';
+	return true;
+}
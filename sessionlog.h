@@ -0,0 +1,130 @@
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "command.h"
+
+/****************************************************************
+sessionlog.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Binary log of played games, with replay and statistics
+
+*****************************************************************/
+
+#ifndef SESSIONLOG_H
+#define SESSIONLOG_H
+
+// A session log starts with the 4 bytes "RRSL" and a version byte, then
+// holds a sequence of records that each start with a tag byte:
+//   SESSION_PUZZLE: an 8 byte puzzle id, a 4 byte length and the puzzle
+//                   in the puzzle file format (see writeBoard)
+//   SESSION_START:  the 8 byte id of a puzzle recorded earlier in the file
+// and after SESSION_START one byte per move, robot id * 4 + direction,
+// until the next tag or the end of the file.  A move of a robot the
+// board does not have is recorded with robot id SESSION_NO_ROBOT.
+// Numbers are little endian.
+// The id is a hash of the puzzle text, so writers appending to the same
+// file never need to agree on ids.  Several writers may append at the
+// same time: each session, with the puzzle record it needs, reaches the
+// file in a single write to a descriptor opened for appending, so
+// sessions from different writers never interleave.
+const unsigned char SESSION_PUZZLE = 0xF0;
+const unsigned char SESSION_START = 0xF1;
+const unsigned char SESSION_NO_ROBOT = 31;
+
+// ==================================================================
+// Appends sessions to a log file.  Each puzzle's text is written the
+// first time this writer starts a session on it.  A session is kept in
+// memory until the next one starts or flush() is called.
+
+class SessionWriter
+{
+	public:
+		SessionWriter();
+		// writes the last session
+		~SessionWriter();
+
+		// returns false and sets 'error' if the file cannot be opened for
+		// appending, or is not a session log (an empty file is not one)
+		bool open(const std::string &filename, std::string &error);
+
+		void startSession(const Board &b);
+		// returns false, and records nothing, if there is no session or the
+		// direction is not one of the four
+		bool addMove(const command &c);
+		// write the current session; returns false if anything could not be written
+		bool flush();
+
+	private:
+		// REPRESENTATION
+		int fd;
+		// the records not yet written
+		std::string pending;
+		bool failed;
+		std::set<unsigned long long> puzzles;
+		// robot id by name in the current session, -1 if there is no such robot
+		std::vector<int> robot_id;
+};
+
+// ==================================================================
+// Reads a session log from start to end, one session at a time.  The
+// input is read in large blocks, and each puzzle is parsed once, the
+// first time it appears.
+
+class SessionReader
+{
+	public:
+		SessionReader(std::istream &istr);
+
+		// move on to the next session, skipping what is left of this one.
+		// Returns false at the end of the log, or if it is malformed, in
+		// which case getError() is not empty.
+		bool nextSession();
+		// the next move of the current session; false at its end.  A move
+		// of a robot the board does not have is returned with robot '?'.
+		bool nextMove(command &c);
+
+		// ACCESSORS
+		unsigned long long getPuzzleId() const
+		{
+			return puzzle_id;
+		}
+		// the board of the current session, with the robots on their starting cells
+		const Board& getBoard() const
+		{
+			return *board;
+		}
+		const std::string& getError() const
+		{
+			return error;
+		}
+
+	private:
+		bool fill();
+		bool read(void *data, size_t length);
+
+		// REPRESENTATION
+		std::istream &istr;
+		std::vector<char> buffer;
+		size_t pos;
+		size_t end;
+		std::map<unsigned long long, Board> boards;
+		unsigned long long puzzle_id;
+		const Board *board;
+		std::string error;
+};
+
+// Replay every session of the log and print a summary: how many were
+// solved, optimally or not, left unsolved or contained an illegal move,
+// and the average number of moves over the optimal solution.  Each
+// puzzle's optimal solution is found once, searching up to max_depth
+// moves, or as many moves as the board has cells if max_depth is not
+// positive.  Returns false if the log is malformed.
+bool scanSessions(std::istream &istr, int max_depth, std::ostream &ostr);
+
+#endif
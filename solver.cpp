@@ -0,0 +1,313 @@
+#include <cmath>
+#include <memory>
+
+#include "parallel.h"
+#include "solver.h"
+#include "stateset.h"
+
+/****************************************************************
+solver.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Depth limited search specialized at compile time for the common
+board sizes and robot counts
+
+*****************************************************************/
+
+
+template <int ROWS, int COLS, int NROBOTS>
+bool solveFixed(const Board &b, const Geometry &g, int max_depth, unsigned int threads, std::vector<command> &path)
+{
+	FixedSolver<ROWS, COLS, NROBOTS> solver(b, g);
+	if (threads > 1)
+		return solveParallel(solver, max_depth, threads, path);
+	return solver.solve(max_depth, path);
+}
+
+// The instantiations we compile.  Almost every game is played on the
+// standard 16x16 board with 4 or 5 robots.
+struct SolverEntry
+{
+	int rows, cols, robots;
+	SolveFunction solve;
+};
+static const SolverEntry solver_table[] =
+{
+	{ 16, 16, 4, &solveFixed<16, 16, 4> },
+	{ 16, 16, 5, &solveFixed<16, 16, 5> },
+};
+
+SolveFunction findSolver(const Board &b)
+{
+	// without a goal there is nothing for the specialized search to aim at
+	if (b.getGoal().row == -1)
+		return NULL;
+	for (unsigned int i = 0; i < sizeof(solver_table) / sizeof(solver_table[0]); i++)
+	{
+		const SolverEntry &e = solver_table[i];
+		if (e.rows == b.getRows() && e.cols == b.getCols() && e.robots == (int)b.numRobots())
+			return e.solve;
+	}
+	return NULL;
+}
+
+
+GenericSolver::GenericSolver(const Board &b, const Geometry &g)
+{
+	geometry = &g;
+	count = b.numRobots();
+	for (int i = 0; i < count; i++)
+	{
+		robots[i] = g.cellIndex(b.getRobotPosition(i));
+		names[i] = b.getRobot(i);
+	}
+	goal_robot = b.getGoalRobot();
+}
+
+bool GenericSolver::atGoal() const
+{
+	return reachesGoal(robots, count, geometry->getGoal(), goal_robot);
+}
+
+int GenericSolver::lowerBound() const
+{
+	int best = UNREACHABLE;
+	for (int i = 0; i < count; i++)
+	{
+		if ((goal_robot == -1 || goal_robot == i) && geometry->getGoalDistance(robots[i]) < best)
+			best = geometry->getGoalDistance(robots[i]);
+	}
+	return best;
+}
+
+// see FixedSolver::search
+bool GenericSolver::search(int depth, int last_robot, unsigned short last_dir, std::vector<command> &path, const std::atomic<bool> *stop)
+{
+	if (stop != NULL && stop->load(std::memory_order_relaxed))
+		return false;
+	if (atGoal())
+		return true;
+	if (lowerBound() > depth)
+		return false;
+	for (int i = 0; i < count; i++)
+	{
+		for (unsigned short d = 0; d < 4; d++)
+		{
+			if (i == last_robot && d == last_dir)
+				continue;
+			int from = robots[i];
+			int to = slide(i, d);
+			if (to == from)
+				continue;
+			robots[i] = to;
+			bool found = search(depth - 1, i, d, path, stop);
+			robots[i] = from;
+			if (found)
+			{
+				path.push_back(command(names[i], i, d));
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool GenericSolver::solve(int max_depth, std::vector<command> &path)
+{
+	if (geometry->getGoal() == -1)
+		return false;
+	for (int depth = 0; depth <= max_depth; depth++)
+	{
+		TraceSpan span("depth", "depth", depth);
+		if (search(depth, -1, 4, path))
+			return true;
+	}
+	return false;
+}
+
+bool solveGeneric(const Board &b, const Geometry &g, int max_depth, unsigned int threads, std::vector<command> &path)
+{
+	GenericSolver solver(b, g);
+	if (threads > 1)
+		return solveParallel(solver, max_depth, threads, path);
+	return solver.solve(max_depth, path);
+}
+
+bool reachesGoal(const int *robots, int count, int goal, int goal_robot)
+{
+	if (goal_robot != -1)
+		return robots[goal_robot] == goal;
+	for (int i = 0; i < count; i++)
+	{
+		if (robots[i] == goal)
+			return true;
+	}
+	return false;
+}
+
+PuzzleCheck checkPuzzle(const Board &b, const Geometry &g, std::string &error)
+{
+	int count = b.numRobots();
+	if (count > MAX_ROBOTS)
+	{
+		error = "the puzzle has more robots than the solvers support";
+		return PUZZLE_INVALID;
+	}
+	int robots[MAX_ROBOTS];
+	for (int i = 0; i < count; i++)
+	{
+		Position p = b.getRobotPosition(i);
+		if (p.row < 1 || p.row > b.getRows() || p.col < 1 || p.col > b.getCols())
+		{
+			error = std::string("robot ") + b.getRobot(i) + " is off the board";
+			return PUZZLE_INVALID;
+		}
+		robots[i] = g.cellIndex(p);
+		for (int j = 0; j < i; j++)
+		{
+			if (robots[j] == robots[i])
+			{
+				error = std::string("robots ") + b.getRobot(j) + " and " + b.getRobot(i) + " are on the same cell";
+				return PUZZLE_INVALID;
+			}
+		}
+	}
+	if (g.getGoal() == -1)
+		return PUZZLE_OK;
+
+	if (b.getGoalRobot() != -1)
+	{
+		if (g.getGoalDistance(robots[b.getGoalRobot()]) != UNREACHABLE)
+			return PUZZLE_OK;
+		error = std::string("robot ") + b.getRobot(b.getGoalRobot()) + " can never reach the goal";
+		return PUZZLE_UNSOLVABLE;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		if (g.getGoalDistance(robots[i]) != UNREACHABLE)
+			return PUZZLE_OK;
+	}
+	error = "no robot can ever reach the goal";
+	return PUZZLE_UNSOLVABLE;
+}
+
+// The same search as shortestSolution with the layers kept in
+// CompressedKeys, and the visited states either in a StateBitmap or, for
+// SORTED_STORAGE, in one more CompressedKeys that each new layer is
+// merged into.
+static int compressedSearch(const Board &b, const Geometry &g, const StateCodec &codec, int *robots, int max_depth, StateStorage storage)
+{
+	int count = b.numRobots();
+	CompressedKeys frontier, next, visited, layer;
+	std::unique_ptr<StateBitmap> bitmap;
+	StateKey start = codec.pack(robots);
+	frontier.push_back(start);
+	frontier.flush();
+	if (storage == BITMAP_STORAGE)
+	{
+		bitmap.reset(new StateBitmap(codec.totalBits()));
+		bitmap->insert(start);
+	}
+	else
+	{
+		visited.push_back(start);
+		visited.flush();
+	}
+	for (int depth = 0; depth <= max_depth && !frontier.empty(); depth++)
+	{
+		TraceSpan span("layer", "depth", depth);
+		next.clear();
+		CompressedKeys::Reader reader(frontier);
+		for (StateKey state; reader.next(state); )
+		{
+			codec.unpack(state, robots);
+			if (reachesGoal(robots, count, g.getGoal(), b.getGoalRobot()))
+				return depth;
+			if (depth == max_depth)
+				continue;
+			for (int i = 0; i < count; i++)
+			{
+				int from = robots[i];
+				for (unsigned short d = 0; d < 4; d++)
+				{
+					int to = g.slide(robots, count, i, d);
+					if (to == from)
+						continue;
+					robots[i] = to;
+					StateKey key = codec.pack(robots);
+					robots[i] = from;
+					// without a bitmap, duplicates are removed when the layer is merged
+					if (storage != BITMAP_STORAGE || bitmap->insert(key))
+						next.push_back(key);
+				}
+			}
+		}
+		next.flush();
+		if (storage == SORTED_STORAGE)
+		{
+			TraceSpan merge("merge", "keys", next.size());
+			layer.clear();
+			CompressedKeys::subtract(next, visited, layer);
+			frontier.swap(layer);
+		}
+		else
+			frontier.swap(next);
+	}
+	return -1;
+}
+
+int shortestSolution(const Board &b, const Geometry &g, int max_depth, StateStorage storage)
+{
+	int count = b.numRobots();
+	int robots[MAX_ROBOTS];
+	for (int i = 0; i < count; i++)
+		robots[i] = g.cellIndex(b.getRobotPosition(i));
+	StateCodec codec(g, robots, count, max_depth);
+	if (g.getGoal() == -1 || !codec.fits())
+		return -1;
+	if (storage == AUTOMATIC_STORAGE)
+		storage = chooseStorage(codec, count, max_depth);
+	if (storage == BITMAP_STORAGE && ldexp(1.0, codec.totalBits()) / 8 > MAX_BITMAP_BYTES)
+		storage = SORTED_STORAGE;
+	if (storage != HASH_STORAGE)
+		return compressedSearch(b, g, codec, robots, max_depth, storage);
+
+	// expand one layer of the search at a time
+	StateSet visited;
+	std::vector<StateKey> frontier, next;
+	StateKey successors[4 * MAX_ROBOTS], added[4 * MAX_ROBOTS];
+	frontier.push_back(codec.pack(robots));
+	visited.insert(frontier[0]);
+	for (int depth = 0; depth <= max_depth && !frontier.empty(); depth++)
+	{
+		TraceSpan span("layer", "depth", depth);
+		next.clear();
+		for (unsigned int k = 0; k < frontier.size(); k++)
+		{
+			codec.unpack(frontier[k], robots);
+			if (reachesGoal(robots, count, g.getGoal(), b.getGoalRobot()))
+				return depth;
+			if (depth == max_depth)
+				continue;
+			// gather every successor first, so the set can look them all up together
+			size_t n = 0;
+			for (int i = 0; i < count; i++)
+			{
+				int from = robots[i];
+				for (unsigned short d = 0; d < 4; d++)
+				{
+					int to = g.slide(robots, count, i, d);
+					if (to == from)
+						continue;
+					robots[i] = to;
+					successors[n++] = codec.pack(robots);
+					robots[i] = from;
+				}
+			}
+			size_t fresh = visited.insert(successors, n, added);
+			next.insert(next.end(), added, added + fresh);
+		}
+		frontier.swap(next);
+	}
+	return -1;
+}
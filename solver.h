@@ -0,0 +1,322 @@
+#include <atomic>
+#include <vector>
+
+#include "board.h"
+#include "command.h"
+#include "codec.h"
+#include "frontier.h"
+#include "geometry.h"
+#include "trace.h"
+
+/****************************************************************
+solver.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Depth limited search specialized at compile time for the common
+board sizes and robot counts
+
+*****************************************************************/
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+// the smallest unsigned type that can hold every cell index of a board
+template <bool FITS_IN_BYTE> struct CellType
+{
+	typedef unsigned short type;
+};
+template <> struct CellType<true>
+{
+	typedef unsigned char type;
+};
+
+// ==================================================================
+// Iterative deepening search over a compact copy of a Board.  The
+// dimensions and the number of robots are template arguments so the
+// tables are fixed size arrays and every loop over the robots has a
+// constant trip count that the compiler can unroll.
+
+template <int ROWS, int COLS, int NROBOTS>
+class FixedSolver
+{
+	public:
+		static const int CELLS = ROWS * COLS;
+		typedef typename CellType<(CELLS <= 256)>::type Cell;
+
+		FixedSolver(const Board &b, const Geometry &g);
+
+		// find a solution with the fewest moves, but no more than max_depth.
+		// Like findPath, the commands are appended last move first.
+		bool solve(int max_depth, std::vector<command> &path);
+		// one depth limited pass from the current robot positions, never
+		// repeating the last move.  Gives up early once 'stop' is set.
+		bool search(int depth, int last_robot, unsigned short last_dir, std::vector<command> &path, const std::atomic<bool> *stop = NULL);
+
+		// ACCESSORS and MODIFIERS used to hand search positions between threads
+		int numRobots() const
+		{
+			return NROBOTS;
+		}
+		char getRobot(int i) const
+		{
+			return names[i];
+		}
+		void getRobots(int *cells) const
+		{
+			for (int i = 0; i < NROBOTS; i++)
+				cells[i] = robots[i];
+		}
+		void setRobots(const int *cells)
+		{
+			for (int i = 0; i < NROBOTS; i++)
+				robots[i] = cells[i];
+		}
+		bool atGoal() const;
+		int lowerBound() const;
+		Cell slide(int i, unsigned short dir) const;
+
+	private:
+		// REPRESENTATION
+		Cell stops[CELLS][4];
+		unsigned char goal_distance[CELLS];
+		Cell robots[NROBOTS];
+		char names[NROBOTS];
+		Cell goal;
+		int goal_robot;
+};
+
+
+template <int ROWS, int COLS, int NROBOTS>
+FixedSolver<ROWS, COLS, NROBOTS>::FixedSolver(const Board &b, const Geometry &g)
+{
+	assert(b.getRows() == ROWS && b.getCols() == COLS);
+	assert(b.numRobots() == (unsigned int)NROBOTS);
+	for (int cell = 0; cell < CELLS; cell++)
+	{
+		for (unsigned short d = 0; d < 4; d++)
+			stops[cell][d] = g.getStop(cell, d);
+		goal_distance[cell] = g.getGoalDistance(cell);
+	}
+	for (int i = 0; i < NROBOTS; i++)
+	{
+		robots[i] = g.cellIndex(b.getRobotPosition(i));
+		names[i] = b.getRobot(i);
+	}
+	goal = g.cellIndex(b.getGoal());
+	goal_robot = b.getGoalRobot();
+}
+
+template <int ROWS, int COLS, int NROBOTS>
+bool FixedSolver<ROWS, COLS, NROBOTS>::atGoal() const
+{
+	if (goal_robot != -1)
+		return robots[goal_robot] == goal;
+	for (int i = 0; i < NROBOTS; i++)
+	{
+		if (robots[i] == goal)
+			return true;
+	}
+	return false;
+}
+
+template <int ROWS, int COLS, int NROBOTS>
+int FixedSolver<ROWS, COLS, NROBOTS>::lowerBound() const
+{
+	if (goal_robot != -1)
+		return goal_distance[robots[goal_robot]];
+	int best = UNREACHABLE;
+	for (int i = 0; i < NROBOTS; i++)
+	{
+		if (goal_distance[robots[i]] < best)
+			best = goal_distance[robots[i]];
+	}
+	return best;
+}
+
+// Where robot i ends up moving in 'dir': the wall stop, cut short by the
+// nearest other robot standing between the robot and that stop.
+template <int ROWS, int COLS, int NROBOTS>
+typename FixedSolver<ROWS, COLS, NROBOTS>::Cell FixedSolver<ROWS, COLS, NROBOTS>::slide(int i, unsigned short dir) const
+{
+	int from = robots[i];
+	int to = stops[from][dir];
+	switch (dir)
+	{
+		case NORTH:
+			for (int j = 0; j < NROBOTS; j++)
+			{
+				int p = robots[j];
+				if (p % COLS == from % COLS && p < from && p >= to)
+					to = p + COLS;
+			}
+			break;
+		case EAST:
+			for (int j = 0; j < NROBOTS; j++)
+			{
+				int p = robots[j];
+				if (p > from && p <= to)
+					to = p - 1;
+			}
+			break;
+		case SOUTH:
+			for (int j = 0; j < NROBOTS; j++)
+			{
+				int p = robots[j];
+				if (p % COLS == from % COLS && p > from && p <= to)
+					to = p - COLS;
+			}
+			break;
+		case WEST:
+			for (int j = 0; j < NROBOTS; j++)
+			{
+				int p = robots[j];
+				if (p < from && p >= to)
+					to = p + 1;
+			}
+			break;
+	}
+	return to;
+}
+
+template <int ROWS, int COLS, int NROBOTS>
+bool FixedSolver<ROWS, COLS, NROBOTS>::search(int depth, int last_robot, unsigned short last_dir, std::vector<command> &path, const std::atomic<bool> *stop)
+{
+	if (stop != NULL && stop->load(std::memory_order_relaxed))
+		return false;
+	if (atGoal())
+		return true;
+	// the goal distance never overestimates, so this branch cannot finish in time
+	if (lowerBound() > depth)
+		return false;
+	for (int i = 0; i < NROBOTS; i++)
+	{
+		for (unsigned short d = 0; d < 4; d++)
+		{
+			if (i == last_robot && d == last_dir)
+				continue;
+			Cell from = robots[i];
+			Cell to = slide(i, d);
+			if (to == from)
+				continue;
+			robots[i] = to;
+			bool found = search(depth - 1, i, d, path, stop);
+			robots[i] = from;
+			if (found)
+			{
+				path.push_back(command(names[i], i, d));
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+template <int ROWS, int COLS, int NROBOTS>
+bool FixedSolver<ROWS, COLS, NROBOTS>::solve(int max_depth, std::vector<command> &path)
+{
+	for (int depth = 0; depth <= max_depth; depth++)
+	{
+		TraceSpan span("depth", "depth", depth);
+		if (search(depth, -1, 4, path))
+			return true;
+	}
+	return false;
+}
+
+
+// ==================================================================
+// The same search as FixedSolver for any board size and robot count.
+// Slower, but unlike findPath it always finds a shortest solution.
+
+class GenericSolver
+{
+	public:
+		GenericSolver(const Board &b, const Geometry &g);
+
+		bool solve(int max_depth, std::vector<command> &path);
+		bool search(int depth, int last_robot, unsigned short last_dir, std::vector<command> &path, const std::atomic<bool> *stop = NULL);
+
+		// ACCESSORS and MODIFIERS used to hand search positions between threads
+		int numRobots() const
+		{
+			return count;
+		}
+		char getRobot(int i) const
+		{
+			return names[i];
+		}
+		void getRobots(int *cells) const
+		{
+			for (int i = 0; i < count; i++)
+				cells[i] = robots[i];
+		}
+		void setRobots(const int *cells)
+		{
+			for (int i = 0; i < count; i++)
+				robots[i] = cells[i];
+		}
+		bool atGoal() const;
+		int lowerBound() const;
+		int slide(int i, unsigned short dir) const
+		{
+			return geometry->slide(robots, count, i, dir);
+		}
+
+	private:
+		// REPRESENTATION
+		const Geometry *geometry;
+		int count;
+		int robots[MAX_ROBOTS];
+		char names[MAX_ROBOTS];
+		int goal_robot;
+};
+
+
+// ==================================================================
+// Runtime dispatch to the matching instantiation.  With more than one
+// thread the search is split between them by solveParallel.
+
+typedef bool (*SolveFunction)(const Board &b, const Geometry &g, int max_depth, unsigned int threads, std::vector<command> &path);
+
+// Returns the specialized solver for the board's size and robot count,
+// or NULL if there is none and the generic findPath must be used.
+SolveFunction findSolver(const Board &b);
+
+// GenericSolver behind the same interface as the specialized solvers
+bool solveGeneric(const Board &b, const Geometry &g, int max_depth, unsigned int threads, std::vector<command> &path);
+
+
+// ==================================================================
+// Breadth first search over packed robot positions, for any board size
+
+// true if the robots satisfy the goal (goal_robot -1 means any robot)
+bool reachesGoal(const int *robots, int count, int goal, int goal_robot);
+
+// What checkPuzzle found, before any search
+enum PuzzleCheck
+{
+	PUZZLE_OK,
+	// two robots share a cell, or a robot is outside the board
+	PUZZLE_INVALID,
+	// no sequence of moves takes a robot that may finish onto the goal
+	PUZZLE_UNSOLVABLE
+};
+
+// Checks that take a few microseconds and save a search that cannot
+// succeed.  The goal distance table assumes a robot can be stopped
+// anywhere, so if it says the goal robot (or, for any robot, every one)
+// can never get there, no search will find a way.  A board without a
+// goal is only checked for its robots.  Sets 'error' unless PUZZLE_OK.
+// readBoard already rejects robots that are off the board or share a
+// cell; those checks are here for boards that don't come through it,
+// such as ones built or edited in code.
+PuzzleCheck checkPuzzle(const Board &b, const Geometry &g, std::string &error);
+
+// The number of moves in the shortest solution.  Returns -1 if there is
+// none using max_depth or fewer moves, or if the robots' rest cells do
+// not fit in a StateKey.  Unless told otherwise the storage for the
+// visited states is picked from the estimated size of the search; a
+// bitmap larger than MAX_BITMAP_BYTES is never used.
+int shortestSolution(const Board &b, const Geometry &g, int max_depth, StateStorage storage = AUTOMATIC_STORAGE);
+
+#endif
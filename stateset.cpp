@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "stateset.h"
+#include "trace.h"
+
+/****************************************************************
+stateset.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Open addressing hash set of packed robot positions
+
+*****************************************************************/
+
+
+const size_t GROUP_SIZE = 16;
+// the control byte of a slot with no key
+const unsigned char EMPTY_SLOT = 0x80;
+// groups moved from the old table by each insert while growing
+const size_t MIGRATE_GROUPS = 4;
+// keys hashed and prefetched together by the batch insert
+const size_t PREFETCH_BLOCK = 32;
+
+// bit i is set if control byte i of the group equals 'value'
+static unsigned int matchGroup(const unsigned char *group, unsigned char value)
+{
+#ifdef __SSE2__
+	__m128i control = _mm_loadu_si128((const __m128i*)group);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8((char)value)));
+#else
+	unsigned int bits = 0;
+	for (size_t i = 0; i < GROUP_SIZE; i++)
+	{
+		if (group[i] == value)
+			bits |= 1 << i;
+	}
+	return bits;
+#endif
+}
+
+static int lowestBit(unsigned int bits)
+{
+#ifdef __GNUC__
+	return __builtin_ctz(bits);
+#else
+	int i = 0;
+	while (!(bits & (1 << i)))
+		i++;
+	return i;
+#endif
+}
+
+static void prefetch(const void *p)
+{
+#ifdef __GNUC__
+	__builtin_prefetch(p);
+#endif
+}
+
+// the splitmix64 finalizer; packed keys differ mostly in their low bits
+unsigned long long StateSet::hash(StateKey key)
+{
+	key ^= key >> 30;
+	key *= 0xbf58476d1ce4e5b9ULL;
+	key ^= key >> 27;
+	key *= 0x94d049bb133111ebULL;
+	key ^= key >> 31;
+	return key;
+}
+
+void StateSet::allocate(Table &t, size_t groups)
+{
+	t.control = std::vector<unsigned char>(groups * GROUP_SIZE, EMPTY_SLOT);
+	t.keys = std::vector<StateKey>(groups * GROUP_SIZE);
+	t.mask = groups - 1;
+}
+
+StateSet::StateSet(size_t expected) : migrated(0), count(0)
+{
+	size_t groups = 1;
+	while (groups * GROUP_SIZE * 7 / 8 < expected)
+		groups *= 2;
+	allocate(table, groups);
+	old.mask = 0;
+}
+
+// The low 7 bits of the hash go in the control byte and the rest pick
+// the first group.  Groups are probed in triangular steps, which visit
+// every group of a power of 2 sized table.
+bool StateSet::find(const Table &t, StateKey key, unsigned long long h)
+{
+	unsigned char tag = h & 0x7F;
+	size_t g = (h >> 7) & t.mask;
+	for (size_t step = 1; ; step++)
+	{
+		const unsigned char *group = &t.control[g * GROUP_SIZE];
+		for (unsigned int match = matchGroup(group, tag); match != 0; match &= match - 1)
+		{
+			if (t.keys[g * GROUP_SIZE + lowestBit(match)] == key)
+				return true;
+		}
+		if (matchGroup(group, EMPTY_SLOT) != 0)
+			return false;
+		g = (g + step) & t.mask;
+	}
+}
+
+// put a key known not to be in the table in the first empty slot of its probe sequence
+void StateSet::place(Table &t, StateKey key, unsigned long long h)
+{
+	size_t g = (h >> 7) & t.mask;
+	for (size_t step = 1; ; step++)
+	{
+		unsigned int empty = matchGroup(&t.control[g * GROUP_SIZE], EMPTY_SLOT);
+		if (empty != 0)
+		{
+			size_t slot = g * GROUP_SIZE + lowestBit(empty);
+			t.control[slot] = h & 0x7F;
+			t.keys[slot] = key;
+			return;
+		}
+		g = (g + step) & t.mask;
+	}
+}
+
+bool StateSet::contains(StateKey key) const
+{
+	unsigned long long h = hash(key);
+	return find(table, key, h) || (!old.keys.empty() && find(old, key, h));
+}
+
+bool StateSet::insert(StateKey key)
+{
+	return insert(key, hash(key));
+}
+
+bool StateSet::insert(StateKey key, unsigned long long h)
+{
+	if (find(table, key, h) || (!old.keys.empty() && find(old, key, h)))
+		return false;
+	if ((count + 1) * 8 > table.keys.size() * 7)
+		grow();
+	place(table, key, h);
+	count++;
+	if (!old.keys.empty())
+		migrate();
+	return true;
+}
+
+size_t StateSet::insert(const StateKey *keys, size_t n, StateKey *added)
+{
+	size_t fresh = 0;
+	unsigned long long h[PREFETCH_BLOCK];
+	for (size_t first = 0; first < n; first += PREFETCH_BLOCK)
+	{
+		size_t last = std::min(n, first + PREFETCH_BLOCK);
+		for (size_t k = first; k < last; k++)
+		{
+			h[k - first] = hash(keys[k]);
+			size_t g = (h[k - first] >> 7) & table.mask;
+			prefetch(&table.control[g * GROUP_SIZE]);
+			prefetch(&table.keys[g * GROUP_SIZE]);
+		}
+		for (size_t k = first; k < last; k++)
+		{
+			if (insert(keys[k], h[k - first]))
+				added[fresh++] = keys[k];
+		}
+	}
+	return fresh;
+}
+
+// start a table twice the size; the old one is emptied into it a few
+// groups at a time by the inserts that follow
+void StateSet::grow()
+{
+	TraceSpan span("grow", "keys", count);
+	while (!old.keys.empty())
+		migrate();
+	std::swap(old, table);
+	allocate(table, 2 * (old.mask + 1));
+	migrated = 0;
+}
+
+void StateSet::migrate()
+{
+	for (size_t n = 0; n < MIGRATE_GROUPS && migrated <= old.mask; n++, migrated++)
+	{
+		for (size_t slot = migrated * GROUP_SIZE; slot < (migrated + 1) * GROUP_SIZE; slot++)
+		{
+			if (old.control[slot] != EMPTY_SLOT)
+				place(table, old.keys[slot], hash(old.keys[slot]));
+		}
+	}
+	if (migrated > old.mask)
+	{
+		std::vector<unsigned char>().swap(old.control);
+		std::vector<StateKey>().swap(old.keys);
+		old.mask = 0;
+	}
+}
+
+
+// ==================================================================
+// Benchmark
+
+// stop collecting keys after this many
+const size_t BENCHMARK_KEYS = 1 << 24;
+
+// nanoseconds per key since 'start'
+static double perKey(std::chrono::steady_clock::time_point start, size_t keys)
+{
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return keys == 0 ? 0 : elapsed.count() / keys;
+}
+
+void benchmarkStateSets(const Board &b, const Geometry &g, int max_depth, std::ostream &ostr)
+{
+	int count = b.numRobots();
+	int robots[MAX_ROBOTS];
+	for (int i = 0; i < count; i++)
+		robots[i] = g.cellIndex(b.getRobotPosition(i));
+	StateCodec codec(g, robots, count, max_depth);
+	if (!codec.fits())
+	{
+		ostr << "the robots' positions do not fit in a StateKey" << '\n';
+		return;
+	}
+
+	// every successor of every state, in the order a breadth first search
+	// makes them; 'ends' marks where each state's successors end
+	std::vector<StateKey> generated;
+	std::vector<size_t> ends;
+	{
+		TraceSpan span("collect");
+		StateSet seen;
+		std::vector<StateKey> frontier, next;
+		frontier.push_back(codec.pack(robots));
+		seen.insert(frontier[0]);
+		for (int depth = 0; depth < max_depth && !frontier.empty() && generated.size() < BENCHMARK_KEYS; depth++)
+		{
+			next.clear();
+			for (unsigned int k = 0; k < frontier.size() && generated.size() < BENCHMARK_KEYS; k++)
+			{
+				codec.unpack(frontier[k], robots);
+				for (int i = 0; i < count; i++)
+				{
+					int from = robots[i];
+					for (unsigned short d = 0; d < 4; d++)
+					{
+						int to = g.slide(robots, count, i, d);
+						if (to == from)
+							continue;
+						robots[i] = to;
+						generated.push_back(codec.pack(robots));
+						robots[i] = from;
+						if (seen.insert(generated.back()))
+							next.push_back(generated.back());
+					}
+				}
+				ends.push_back(generated.size());
+			}
+			frontier.swap(next);
+		}
+	}
+
+	// lookups are of every generated key, so they all hit, as the
+	// search's "seen this one?" checks mostly do
+	std::chrono::steady_clock::time_point start;
+	double times[5];
+	size_t distinct, hits[2] = { 0, 0 }, bytes;
+	{
+		TraceSpan span("unordered_set");
+		start = std::chrono::steady_clock::now();
+		std::unordered_set<StateKey> set;
+		for (size_t k = 0; k < generated.size(); k++)
+			set.insert(generated[k]);
+		times[0] = perKey(start, generated.size());
+		start = std::chrono::steady_clock::now();
+		for (size_t k = 0; k < generated.size(); k++)
+			hits[0] += set.count(generated[k]);
+		times[1] = perKey(start, generated.size());
+		distinct = set.size();
+	}
+	{
+		TraceSpan span("StateSet");
+		start = std::chrono::steady_clock::now();
+		StateSet set;
+		for (size_t k = 0; k < generated.size(); k++)
+			set.insert(generated[k]);
+		times[2] = perKey(start, generated.size());
+		start = std::chrono::steady_clock::now();
+		for (size_t k = 0; k < generated.size(); k++)
+			hits[1] += set.contains(generated[k]);
+		times[3] = perKey(start, generated.size());
+		bytes = set.numBytes();
+	}
+	{
+		TraceSpan span("StateSet batch");
+		start = std::chrono::steady_clock::now();
+		StateSet set;
+		StateKey added[4 * MAX_ROBOTS];
+		for (size_t e = 0, first = 0; e < ends.size(); first = ends[e++])
+			set.insert(&generated[first], ends[e] - first, added);
+		times[4] = perKey(start, generated.size());
+	}
+
+	ostr << generated.size() << " keys generated, " << distinct << " distinct";
+	if (hits[0] != generated.size() || hits[1] != generated.size())
+		ostr << " (lookups missed!)";
+	ostr << '\n';
+	ostr << "std::unordered_set: " << times[0] << " ns per insert, " << times[1] << " ns per lookup" << '\n';
+	ostr << "StateSet:           " << times[2] << " ns per insert, " << times[3] << " ns per lookup, "
+	     << times[4] << " ns per batched insert, " << (distinct == 0 ? 0 : (double)bytes / distinct) << " bytes per key" << '\n';
+}
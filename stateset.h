@@ -0,0 +1,88 @@
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include "board.h"
+#include "codec.h"
+#include "geometry.h"
+
+/****************************************************************
+stateset.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Open addressing hash set of packed robot positions
+
+*****************************************************************/
+
+#ifndef STATESET_H
+#define STATESET_H
+
+// ==================================================================
+// A set of StateKeys laid out like a SwissTable: slots come in groups
+// of 16, and each slot has a control byte that is either EMPTY or 7
+// bits of the key's hash.  A lookup compares the 7 bits against a whole
+// group's control bytes at once (with SSE2 where available) and only
+// looks at the keys that match, so it usually touches one cache line of
+// control bytes and one of keys.  Keys are never removed, so the first
+// group with an empty slot ends every probe sequence.
+//
+// When the table fills up a table twice the size is started, and each
+// insert afterwards moves a few groups from the old table across, so no
+// single insert pays for rehashing everything.
+
+class StateSet
+{
+	public:
+		StateSet(size_t expected = 0);
+
+		// returns true if the key was not in the set before
+		bool insert(StateKey key);
+		bool contains(StateKey key) const;
+		// Insert keys[0 .. count-1], for example every position one move
+		// from a state, and copy the ones that were not in the set to
+		// 'added'.  The slots of the whole block are prefetched before any
+		// is examined.  Returns how many were added.
+		size_t insert(const StateKey *keys, size_t count, StateKey *added);
+
+		// ACCESSORS
+		size_t size() const
+		{
+			return count;
+		}
+		size_t numBytes() const
+		{
+			return table.control.capacity() + table.keys.capacity() * sizeof(StateKey) +
+			       old.control.capacity() + old.keys.capacity() * sizeof(StateKey);
+		}
+
+	private:
+		struct Table
+		{
+			std::vector<unsigned char> control;
+			std::vector<StateKey> keys;
+			// the number of groups minus one; the number of groups is a power of 2
+			size_t mask;
+		};
+
+		static unsigned long long hash(StateKey key);
+		static bool find(const Table &t, StateKey key, unsigned long long h);
+		static void place(Table &t, StateKey key, unsigned long long h);
+		static void allocate(Table &t, size_t groups);
+		bool insert(StateKey key, unsigned long long h);
+		void grow();
+		void migrate();
+
+		// REPRESENTATION
+		Table table;
+		// the table being emptied into 'table' after a grow, if any
+		Table old;
+		size_t migrated;
+		size_t count;
+};
+
+// Time StateSet against std::unordered_set on the keys a breadth first
+// search of the puzzle generates, in the order it generates them, and
+// print the results.
+void benchmarkStateSets(const Board &b, const Geometry &g, int max_depth, std::ostream &ostr);
+
+#endif
@@ -0,0 +1,330 @@
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tablebase.h"
+#include "solver.h"
+#include "trace.h"
+
+/****************************************************************
+tablebase.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Precomputed optimal move counts for every position of a small board
+
+*****************************************************************/
+
+
+const unsigned int TABLEBASE_VERSION = 1;
+
+unsigned long long geometryFingerprint(const Geometry &g)
+{
+	// FNV-1a over the dimensions and every cell's walls
+	unsigned long long hash = 14695981039346656037ULL;
+	unsigned int values[2] = { (unsigned int)g.getRows(), (unsigned int)g.getCols() };
+	for (int i = 0; i < 2; i++)
+	{
+		hash ^= values[i];
+		hash *= 1099511628211ULL;
+	}
+	for (int cell = 0; cell < g.numCells(); cell++)
+	{
+		hash ^= g.getWalls(cell);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// the position of a configuration within one goal's entries
+static unsigned long long configurationIndex(const int *robots, int count, int cells)
+{
+	unsigned long long index = 0;
+	for (int i = count - 1; i >= 0; i--)
+		index = index * cells + robots[i];
+	return index;
+}
+
+static void configurationRobots(unsigned long long index, int *robots, int count, int cells)
+{
+	for (int i = 0; i < count; i++)
+	{
+		robots[i] = index % cells;
+		index /= cells;
+	}
+}
+
+static bool occupied(const int *robots, int count, int cell)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (robots[i] == cell)
+			return true;
+	}
+	return false;
+}
+
+
+// ==================================================================
+// Building
+
+// Fill in the entries of one goal.  'entries' points at the goal's first
+// byte; every goal starts on a byte boundary so threads never share one.
+static void buildGoal(const Geometry &g, int count, int goal, int goal_robot, unsigned long long configurations, unsigned char *entries)
+{
+	TraceSpan span("goal", "cell", goal);
+	int cells = g.numCells();
+	int robots[MAX_ROBOTS];
+	std::vector<unsigned char> distance(configurations, TABLEBASE_UNKNOWN);
+	std::vector<unsigned long long> frontier, next;
+
+	// every legal configuration that already satisfies the goal
+	for (unsigned long long index = 0; index < configurations; index++)
+	{
+		configurationRobots(index, robots, count, cells);
+		bool legal = true;
+		for (int i = 1; i < count && legal; i++)
+			legal = !occupied(robots, i, robots[i]);
+		if (legal && reachesGoal(robots, count, goal, goal_robot))
+		{
+			distance[index] = 0;
+			frontier.push_back(index);
+		}
+	}
+
+	// Work backwards: a robot that now rests at 'to' after moving in
+	// direction d could have started from any cell behind it on the same
+	// line, as long as nothing stood in between and something (a wall or
+	// another robot) stopped it at 'to'.
+	for (unsigned int moves = 1; moves <= TABLEBASE_MAX_MOVES && !frontier.empty(); moves++)
+	{
+		next.clear();
+		for (unsigned int k = 0; k < frontier.size(); k++)
+		{
+			configurationRobots(frontier[k], robots, count, cells);
+			for (int i = 0; i < count; i++)
+			{
+				int to = robots[i];
+				for (unsigned short d = 0; d < 4; d++)
+				{
+					bool stopped = (g.getWalls(to) & (1 << d)) || occupied(robots, count, g.step(to, d));
+					if (!stopped)
+						continue;
+					unsigned short back = (d + 2) % 4;
+					for (int from = to; !(g.getWalls(from) & (1 << back)); )
+					{
+						from = g.step(from, back);
+						if (occupied(robots, count, from))
+							break;
+						robots[i] = from;
+						unsigned long long index = configurationIndex(robots, count, cells);
+						if (distance[index] == TABLEBASE_UNKNOWN)
+						{
+							distance[index] = moves;
+							next.push_back(index);
+						}
+					}
+					robots[i] = to;
+				}
+			}
+		}
+		frontier.swap(next);
+	}
+
+	for (unsigned long long index = 0; index < configurations; index += 2)
+	{
+		unsigned char high = index + 1 < configurations ? distance[index + 1] : TABLEBASE_UNKNOWN;
+		entries[index / 2] = distance[index] | (high << 4);
+	}
+}
+
+bool buildTablebase(const Board &b, const Geometry &g, unsigned int threads, const std::string &filename, std::string &error)
+{
+	int count = b.numRobots();
+	int cells = g.numCells();
+	TablebaseHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "RRTB", 4);
+	header.version = TABLEBASE_VERSION;
+	header.rows = g.getRows();
+	header.cols = g.getCols();
+	header.robots = count;
+	header.fingerprint = geometryFingerprint(g);
+	// cells ^ robots, checked before each multiplication so it cannot overflow
+	header.configurations = 1;
+	for (int i = 0; i < count; i++)
+	{
+		if (header.configurations > TABLEBASE_MAX_CONFIGURATIONS / cells)
+		{
+			error = "a tablebase for this many robots on a board this size would be too large";
+			return false;
+		}
+		header.configurations *= cells;
+	}
+	header.goal_stride = (header.configurations + 1) / 2 * 2;
+	unsigned long long goals = (unsigned long long)(count + 1) * cells;
+	unsigned long long length = sizeof(header) + goals * header.goal_stride / 2;
+	if (length > TABLEBASE_MAX_BYTES)
+	{
+		error = "a tablebase for this many robots on a board this size would be too large";
+		return false;
+	}
+
+	// only a regular file is written, so removing it on failure is safe
+	int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+	{
+		error = "could not create " + filename;
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+	// from here on a failure removes the partly written file
+	void *map = ftruncate(fd, length) == 0 ? mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (map == MAP_FAILED)
+	{
+		error = "could not create " + filename;
+		unlink(filename.c_str());
+		return false;
+	}
+	memcpy(map, &header, sizeof(header));
+	unsigned char *entries = (unsigned char*)map + sizeof(header);
+
+	// the threads take the next unbuilt goal until there are none left
+	std::atomic<unsigned long long> next_goal(0);
+	std::vector<std::thread> workers;
+	unsigned long long max_threads = TABLEBASE_MAX_BUILD_MEMORY / (header.configurations * TABLEBASE_BUILD_BYTES_PER_CONFIGURATION);
+	if (threads > max_threads)
+		threads = max_threads;
+	if (threads == 0)
+		threads = 1;
+	for (unsigned int t = 0; t < threads; t++)
+	{
+		workers.push_back(std::thread([&]()
+		{
+			for (unsigned long long goal; (goal = next_goal.fetch_add(1)) < goals; )
+			{
+				int goal_robot = goal / cells == (unsigned long long)count ? -1 : (int)(goal / cells);
+				buildGoal(g, count, goal % cells, goal_robot, header.configurations, entries + goal * header.goal_stride / 2);
+			}
+		}));
+	}
+	for (unsigned int t = 0; t < workers.size(); t++)
+		workers[t].join();
+
+	bool written = msync(map, length, MS_SYNC) == 0;
+	munmap(map, length);
+	if (!written)
+	{
+		error = "could not write " + filename;
+		unlink(filename.c_str());
+	}
+	return written;
+}
+
+
+// ==================================================================
+// Lookup
+
+Tablebase::Tablebase() : header(NULL), entries(NULL), length(0)
+{
+}
+
+Tablebase::~Tablebase()
+{
+	if (header != NULL)
+		munmap((void*)header, length);
+}
+
+bool Tablebase::open(const std::string &filename, std::string &error)
+{
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0)
+	{
+		error = "could not open " + filename + " for reading";
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+	length = info.st_size;
+	void *map = length >= sizeof(TablebaseHeader) ? mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (map == MAP_FAILED)
+	{
+		error = filename + " is not a tablebase";
+		return false;
+	}
+	header = (const TablebaseHeader*)map;
+	entries = (const unsigned char*)map + sizeof(TablebaseHeader);
+	unsigned long long goals = (unsigned long long)(header->robots + 1) * header->rows * header->cols;
+	if (memcmp(header->magic, "RRTB", 4) != 0 || header->version != TABLEBASE_VERSION ||
+	    length < sizeof(TablebaseHeader) + goals * header->goal_stride / 2)
+	{
+		error = filename + " is not a tablebase";
+		munmap(map, length);
+		header = NULL;
+		return false;
+	}
+	return true;
+}
+
+bool Tablebase::matches(const Board &b, const Geometry &g) const
+{
+	return header != NULL && header->rows == (unsigned int)g.getRows() && header->cols == (unsigned int)g.getCols() &&
+	       header->robots == b.numRobots() && header->fingerprint == geometryFingerprint(g);
+}
+
+unsigned int Tablebase::lookup(const int *robots, int goal, int goal_robot) const
+{
+	int cells = header->rows * header->cols;
+	unsigned long long slot = goal_robot == -1 ? header->robots : goal_robot;
+	unsigned long long index = (slot * cells + goal) * header->goal_stride + configurationIndex(robots, header->robots, cells);
+	return (entries[index / 2] >> (index % 2 * 4)) & 0xF;
+}
+
+bool Tablebase::solve(const Board &b, const Geometry &g, std::vector<command> &path) const
+{
+	if (!matches(b, g) || g.getGoal() == -1)
+		return false;
+	int count = b.numRobots();
+	int robots[MAX_ROBOTS];
+	for (int i = 0; i < count; i++)
+		robots[i] = g.cellIndex(b.getRobotPosition(i));
+	unsigned int distance = lookup(robots, g.getGoal(), b.getGoalRobot());
+	if (distance == TABLEBASE_UNKNOWN)
+		return false;
+
+	std::vector<command> moves;
+	while (distance > 0)
+	{
+		bool stepped = false;
+		for (int i = 0; i < count && !stepped; i++)
+		{
+			for (unsigned short d = 0; d < 4 && !stepped; d++)
+			{
+				int from = robots[i];
+				robots[i] = g.slide(robots, count, i, d);
+				if (robots[i] != from && lookup(robots, g.getGoal(), b.getGoalRobot()) == distance - 1)
+				{
+					moves.push_back(command(b.getRobot(i), i, d));
+					stepped = true;
+				}
+				else
+					robots[i] = from;
+			}
+		}
+		// a consistent table always has such a move
+		if (!stepped)
+			return false;
+		distance--;
+	}
+	for (int i = moves.size() - 1; i >= 0; i--)
+		path.push_back(moves[i]);
+	return true;
+}
@@ -0,0 +1,101 @@
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "command.h"
+#include "geometry.h"
+
+/****************************************************************
+tablebase.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Precomputed optimal move counts for every position of a small board
+
+*****************************************************************/
+
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+// distances are stored in 4 bits; this value means "further than
+// TABLEBASE_MAX_MOVES moves, or not reachable at all"
+const unsigned int TABLEBASE_MAX_MOVES = 14;
+const unsigned int TABLEBASE_UNKNOWN = 15;
+
+// The start of a tablebase file.  It is followed by the distances, two
+// per byte, low nibble first.  Entry (goal, robots) is at
+//     goal * goal_stride + robots[0] + robots[1] * cells + ...
+// where goal = goal robot * cells + goal cell, and goal robot is the
+// robot's id, or the number of robots for "any".
+struct TablebaseHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int rows;
+	unsigned int cols;
+	unsigned int robots;
+	unsigned int reserved;
+	// identifies the wall layout the table was built for
+	unsigned long long fingerprint;
+	// robot configurations per goal, cells ^ robots
+	unsigned long long configurations;
+	// entries from one goal to the next, rounded up to whole bytes
+	unsigned long long goal_stride;
+};
+
+// Tables are refused above these sizes: the robot configurations of one
+// goal, and the whole file.
+const unsigned long long TABLEBASE_MAX_CONFIGURATIONS = 1ULL << 26;
+const unsigned long long TABLEBASE_MAX_BYTES = 1ULL << 32;
+// Each building thread holds a byte per configuration of its goal, and
+// two frontiers of 8 byte entries that can each grow to every
+// configuration.  No more threads build at once than fit in this much
+// memory between them.
+const unsigned long long TABLEBASE_BUILD_BYTES_PER_CONFIGURATION = 17;
+const unsigned long long TABLEBASE_MAX_BUILD_MEMORY = 1ULL << 32;
+
+// a hash of the board size and walls, stored in the header
+unsigned long long geometryFingerprint(const Geometry &g);
+
+// Retrograde analysis: for every goal, a breadth first search backwards
+// from the positions that satisfy it finds the distance of every robot
+// configuration.  Goals are shared out between 'threads' threads, fewer
+// if TABLEBASE_MAX_BUILD_MEMORY would not hold them all, each writing
+// its own part of the memory mapped output file.  Only the
+// board's size, walls and number of robots are used.  Returns false and
+// sets 'error', leaving no file behind, if the table would be larger
+// than the limits above or cannot be written.
+bool buildTablebase(const Board &b, const Geometry &g, unsigned int threads, const std::string &filename, std::string &error);
+
+// ==================================================================
+// A tablebase file mapped read only into memory.  Solving is a walk
+// through the table: from the current position take any move that
+// lowers the stored distance by one.
+
+class Tablebase
+{
+	public:
+		Tablebase();
+		~Tablebase();
+
+		// returns false and sets 'error' if the file cannot be mapped or is not a tablebase
+		bool open(const std::string &filename, std::string &error);
+		// true if the table was built for this board's size, walls and number of robots
+		bool matches(const Board &b, const Geometry &g) const;
+
+		// the fewest moves to the goal, or TABLEBASE_UNKNOWN
+		unsigned int lookup(const int *robots, int goal, int goal_robot) const;
+		// a shortest solution for the board's current position, last move
+		// first like findPath; false if the table has no answer for it
+		bool solve(const Board &b, const Geometry &g, std::vector<command> &path) const;
+
+	private:
+		// not copyable, the mapping belongs to one object
+		Tablebase(const Tablebase&);
+		Tablebase& operator=(const Tablebase&);
+
+		// REPRESENTATION
+		const TablebaseHeader *header;
+		const unsigned char *entries;
+		size_t length;
+};
+#endif
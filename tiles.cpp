@@ -0,0 +1,310 @@
+#include <fstream>
+
+#include "tiles.h"
+
+/****************************************************************
+tiles.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Boards put together from four rotatable quadrant tiles
+
+*****************************************************************/
+
+
+// ==================================================================
+// Tile
+
+Tile::Tile(const std::string &name_, int size_) : name(name_), size(size_)
+{
+	walls[0] = std::vector<unsigned char>(size * size, 0);
+}
+
+void Tile::addWall(int cell, unsigned short dir)
+{
+	walls[0][cell] |= 1 << dir;
+}
+
+void Tile::prepare()
+{
+	// turning clockwise moves (r, c) to (c, size - 1 - r), counting from
+	// 0, and turns each wall one direction clockwise
+	for (int rotation = 1; rotation < 4; rotation++)
+	{
+		walls[rotation] = std::vector<unsigned char>(size * size);
+		for (int r = 0; r < size; r++)
+		{
+			for (int c = 0; c < size; c++)
+			{
+				unsigned char w = walls[rotation - 1][r * size + c];
+				walls[rotation][c * size + (size - 1 - r)] = ((w << 1) | (w >> 3)) & 0xF;
+			}
+		}
+	}
+
+	// the same sweeps as Geometry::computeRowStops, with the tile's edges
+	// stopping every slide
+	for (int rotation = 0; rotation < 4; rotation++)
+	{
+		const std::vector<unsigned char> &w = walls[rotation];
+		std::vector<int> &s = stops[rotation];
+		s = std::vector<int>(size * size * 4);
+		for (int i = 0; i < size; i++)
+		{
+			for (int j = 0; j < size; j++)
+			{
+				// along row i from the west, and down column i from the north
+				int cell = i * size + j;
+				s[cell * 4 + WEST] = (j == 0 || (w[cell] & (1 << WEST))) ? cell : s[(cell - 1) * 4 + WEST];
+				cell = j * size + i;
+				s[cell * 4 + NORTH] = (j == 0 || (w[cell] & (1 << NORTH))) ? cell : s[(cell - size) * 4 + NORTH];
+			}
+			for (int j = size - 1; j >= 0; j--)
+			{
+				int cell = i * size + j;
+				s[cell * 4 + EAST] = (j == size - 1 || (w[cell] & (1 << EAST))) ? cell : s[(cell + 1) * 4 + EAST];
+				cell = j * size + i;
+				s[cell * 4 + SOUTH] = (j == size - 1 || (w[cell] & (1 << SOUTH))) ? cell : s[(cell + size) * 4 + SOUTH];
+			}
+		}
+	}
+}
+
+
+// ==================================================================
+// TileLibrary
+
+bool TileLibrary::load(std::istream &istr, std::string &error)
+{
+	PuzzleTokens tokens(istr);
+	std::string token;
+	while (tokens.next(token))
+	{
+		std::string name;
+		int size;
+		if (token != "tile" || !tokens.next(name) || !tokens.nextInt(size) || size < 1 || size > MAX_BOARD_SIDE / 2)
+		{
+			error = tokens.where() + "expected tile <name> <size>";
+			return false;
+		}
+		if (tiles.find(name) != tiles.end())
+		{
+			error = tokens.where() + "tile " + name + " is defined twice";
+			return false;
+		}
+		Tile tile(name, size);
+		while (true)
+		{
+			if (!tokens.next(token))
+			{
+				error = tokens.where() + "tile " + name + " has no end";
+				return false;
+			}
+			if (token == "end")
+				break;
+			// walls on the tile's own edges, half unit 1 and 2 * size + 1, are allowed
+			std::string at = tokens.where();
+			if (token == "vertical_wall")
+			{
+				int r, c;
+				if (!tokens.nextInt(r) || !tokens.nextHalf(c) || r < 1 || r > size || c > 2 * size + 1)
+				{
+					error = at + "tile " + name + ": vertical_wall is not next to a cell of the tile";
+					return false;
+				}
+				int left = c / 2;
+				if (left >= 1)
+					tile.addWall((r - 1) * size + left - 1, EAST);
+				if (left < size)
+					tile.addWall((r - 1) * size + left, WEST);
+			}
+			else if (token == "horizontal_wall")
+			{
+				int r, c;
+				if (!tokens.nextHalf(r) || !tokens.nextInt(c) || c < 1 || c > size || r > 2 * size + 1)
+				{
+					error = at + "tile " + name + ": horizontal_wall is not next to a cell of the tile";
+					return false;
+				}
+				int above = r / 2;
+				if (above >= 1)
+					tile.addWall((above - 1) * size + c - 1, SOUTH);
+				if (above < size)
+					tile.addWall(above * size + c - 1, NORTH);
+			}
+			else
+			{
+				error = at + "tile " + name + ": unknown token " + token;
+				return false;
+			}
+		}
+		tile.prepare();
+		tiles.insert(std::make_pair(name, tile));
+	}
+	return true;
+}
+
+const Tile* TileLibrary::find(const std::string &name) const
+{
+	std::map<std::string, Tile>::const_iterator t = tiles.find(name);
+	return t == tiles.end() ? NULL : &t->second;
+}
+
+const TileLibrary* loadTileLibrary(const std::string &filename, std::string &error)
+{
+	static std::mutex lock;
+	static std::map<std::string, TileLibrary> libraries;
+	std::lock_guard<std::mutex> guard(lock);
+	std::map<std::string, TileLibrary>::iterator itr = libraries.find(filename);
+	if (itr != libraries.end())
+		return &itr->second;
+	std::ifstream istr(filename.c_str());
+	if (!istr)
+	{
+		error = "could not open " + filename + " for reading";
+		return NULL;
+	}
+	TileLibrary library;
+	if (!library.load(istr, error))
+	{
+		error = filename + ": " + error;
+		return NULL;
+	}
+	return &libraries.insert(std::make_pair(filename, library)).first->second;
+}
+
+
+// ==================================================================
+// Assembly
+
+// the wall masks of the whole board: each tile's own walls, the walls
+// its neighbours declare on their shared edges, and the outer edges
+static std::vector<unsigned char> combineWalls(const TileLayout &layout)
+{
+	int size = layout.tiles[0]->getSize();
+	int cols = 2 * size;
+	std::vector<unsigned char> walls(cols * cols);
+	for (int q = 0; q < 4; q++)
+	{
+		int first = (q / 2) * size * cols + (q % 2) * size;
+		for (int r = 0; r < size; r++)
+		{
+			for (int c = 0; c < size; c++)
+				walls[first + r * cols + c] = layout.tiles[q]->getWalls(layout.rotations[q], r * size + c);
+		}
+	}
+	for (int r = 0; r < cols; r++)
+	{
+		for (int c = 0; c < cols; c++)
+		{
+			int cell = r * cols + c;
+			if (r == 0 || (walls[cell - cols] & (1 << SOUTH)))
+				walls[cell] |= 1 << NORTH;
+			if (c == cols - 1 || (walls[cell + 1] & (1 << WEST)))
+				walls[cell] |= 1 << EAST;
+			if (r == cols - 1 || (walls[cell + cols] & (1 << NORTH)))
+				walls[cell] |= 1 << SOUTH;
+			if (c == 0 || (walls[cell - 1] & (1 << EAST)))
+				walls[cell] |= 1 << WEST;
+		}
+	}
+	return walls;
+}
+
+Board assembleBoard(const TileLayout &layout)
+{
+	std::vector<unsigned char> walls = combineWalls(layout);
+	int cols = 2 * layout.tiles[0]->getSize();
+	Board b(cols, cols);
+	for (int r = 1; r <= cols; r++)
+	{
+		for (int c = 1; c <= cols; c++)
+		{
+			unsigned char w = walls[(r - 1) * cols + (c - 1)];
+			if (c < cols && (w & (1 << EAST)))
+				b.addVerticalWall(r, c + 0.5);
+			if (r < cols && (w & (1 << SOUTH)))
+				b.addHorizontalWall(r + 0.5, c);
+		}
+	}
+	return b;
+}
+
+// A slide that stops at an open edge of its tile carries on into the
+// neighbouring tile, where it stops for good: the far side of that tile
+// is the edge of the board.
+Geometry assembleGeometry(const TileLayout &layout, const Board &b)
+{
+	std::vector<unsigned char> walls = combineWalls(layout);
+	int size = layout.tiles[0]->getSize();
+	int cols = 2 * size;
+
+	// the board cell of every tile cell, per quadrant
+	std::vector<int> board_cell[4];
+	for (int q = 0; q < 4; q++)
+	{
+		int first = (q / 2) * size * cols + (q % 2) * size;
+		for (int local = 0; local < size * size; local++)
+			board_cell[q].push_back(first + (local / size) * cols + local % size);
+	}
+	// crossing an edge in each direction: the neighbouring quadrant is
+	// q ^ across[d], and the local cell changes by enter[d]
+	const int across[4] = { 2, 1, 2, 1 };
+	const int enter[4] = { (size - 1) * size, 1 - size, (1 - size) * size, size - 1 };
+
+	std::vector<int> stops(cols * cols * 4);
+	for (int q = 0; q < 4; q++)
+	{
+		const Tile *tile = layout.tiles[q];
+		for (int local = 0; local < size * size; local++)
+		{
+			int cell = board_cell[q][local];
+			for (unsigned short d = 0; d < 4; d++)
+			{
+				int edge = tile->getStop(layout.rotations[q], local, d);
+				int stop = board_cell[q][edge];
+				if (!(walls[stop] & (1 << d)))
+				{
+					int next = q ^ across[d];
+					stop = board_cell[next][layout.tiles[next]->getStop(layout.rotations[next], edge + enter[d], d)];
+				}
+				stops[cell * 4 + d] = stop;
+			}
+		}
+	}
+	return Geometry(b, walls, stops);
+}
+
+Board readTiledBoard(PuzzleTokens &tokens, const TileLibrary &library, TileLayout &layout, std::string &error)
+{
+	std::string token;
+	if (!tokens.next(token) || token != "quadrants")
+	{
+		error = tokens.where() + "a tiled puzzle must list its quadrants";
+		return Board(0, 0);
+	}
+	for (int q = 0; q < 4; q++)
+	{
+		std::string name;
+		if (!tokens.next(name) || !tokens.nextInt(layout.rotations[q]) || layout.rotations[q] < 0 || layout.rotations[q] > 3)
+		{
+			error = tokens.where() + "quadrants needs four tile names, each followed by a rotation from 0 to 3";
+			return Board(0, 0);
+		}
+		layout.tiles[q] = library.find(name);
+		if (layout.tiles[q] == NULL)
+		{
+			error = tokens.where() + "there is no tile " + name;
+			return Board(0, 0);
+		}
+		if (layout.tiles[q]->getSize() != layout.tiles[0]->getSize())
+		{
+			error = tokens.where() + "the quadrant tiles are not all the same size";
+			return Board(0, 0);
+		}
+	}
+
+	// the walls all come from the tiles, so the tiles' tables stay valid
+	Board b = assembleBoard(layout);
+	readBoard(tokens, b, error, false);
+	return b;
+}
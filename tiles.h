@@ -0,0 +1,120 @@
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "geometry.h"
+
+/****************************************************************
+tiles.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Boards put together from four rotatable quadrant tiles
+
+*****************************************************************/
+
+#ifndef TILES_H
+#define TILES_H
+
+// ==================================================================
+// One quadrant of a board: a square of cells and its walls.  Walls on
+// the tile's own edge are allowed; on the outside of the board they
+// change nothing, and where two tiles meet a wall declared by either one
+// separates them.
+//
+// The wall masks and slide stops of all four orientations are worked
+// out once, when the tile is loaded.  A stop is local to the tile: a
+// slide that reaches an edge without a wall stops there, and the board
+// it is assembled into continues it into the neighbouring tile.
+
+class Tile
+{
+	public:
+		Tile(const std::string &name, int size);
+
+		// MODIFIER, local coordinates as in the puzzle file format
+		void addWall(int cell, unsigned short dir);
+		// work out the tables of every rotation; call once all walls are added
+		void prepare();
+
+		// ACCESSORS.  A rotation is a number of clockwise quarter turns
+		// and a cell is (row - 1) * size + (col - 1) after turning.
+		const std::string& getName() const
+		{
+			return name;
+		}
+		int getSize() const
+		{
+			return size;
+		}
+		unsigned char getWalls(int rotation, int cell) const
+		{
+			return walls[rotation][cell];
+		}
+		int getStop(int rotation, int cell, unsigned short dir) const
+		{
+			return stops[rotation][cell * 4 + dir];
+		}
+
+	private:
+		// REPRESENTATION
+		std::string name;
+		int size;
+		std::vector<unsigned char> walls[4];
+		std::vector<int> stops[4];
+};
+
+// ==================================================================
+// A set of named tiles, read from a tile library file:
+//   tile <name> <size>
+//   vertical_wall <row> <col>
+//   horizontal_wall <row> <col>
+//   ...
+//   end
+// with the same half unit wall coordinates as a puzzle file, counted
+// from the tile's own top left corner.
+
+class TileLibrary
+{
+	public:
+		// returns false and sets 'error', with the line and column of the
+		// problem, if the library is malformed
+		bool load(std::istream &istr, std::string &error);
+		// NULL if there is no tile with that name
+		const Tile* find(const std::string &name) const;
+
+	private:
+		// REPRESENTATION
+		std::map<std::string, Tile> tiles;
+};
+
+// The library in 'filename', read the first time it is asked for and
+// kept for the rest of the run, so every board put together from it
+// shares its prepared tiles.  NULL, with 'error' set, if it cannot be
+// read.
+const TileLibrary* loadTileLibrary(const std::string &filename, std::string &error);
+
+// The four quadrants of a board, north west, north east, south west and
+// south east, each a tile of the same size turned some quarter turns.
+struct TileLayout
+{
+	const Tile *tiles[4];
+	int rotations[4];
+};
+
+// A board of the layout's walls, with no robots and no goal
+Board assembleBoard(const TileLayout &layout);
+// The Geometry of such a board, after robots and the goal are placed,
+// combined from the tiles' tables instead of computed from the walls
+Geometry assembleGeometry(const TileLayout &layout, const Board &b);
+
+// Read a tiled puzzle, which starts
+//   quadrants <tile> <rotation> <tile> <rotation> <tile> <rotation> <tile> <rotation>
+// in the order of TileLayout, followed by robots and the goal as in a
+// puzzle file.  Sets 'error', with the line and column of the problem,
+// if the input is malformed or has walls of its own.
+Board readTiledBoard(PuzzleTokens &tokens, const TileLibrary &library, TileLayout &layout, std::string &error);
+
+#endif
@@ -0,0 +1,124 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "trace.h"
+
+/****************************************************************
+trace.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Timeline of the solver phases in the Chrome trace event format
+
+*****************************************************************/
+
+
+// events kept per thread before the oldest are overwritten
+const unsigned int TRACE_BUFFER_SIZE = 1 << 16;
+
+struct TraceEvent
+{
+	const char *name;
+	const char *arg_name;
+	int arg;
+	long long start;
+	long long duration;
+};
+
+// Only the owning thread writes a buffer.  'count' is published after
+// the event is stored, so a reader sees complete events only.
+struct TraceBuffer
+{
+	TraceBuffer(int id) : thread_id(id), count(0), events(TRACE_BUFFER_SIZE)
+	{
+	}
+	int thread_id;
+	std::atomic<unsigned long long> count;
+	std::vector<TraceEvent> events;
+};
+
+static std::atomic<bool> tracing(false);
+static std::chrono::steady_clock::time_point trace_epoch;
+
+// every buffer ever created; they live until the program exits so the
+// events of finished threads can still be written out
+static std::mutex trace_buffers_lock;
+static std::vector<TraceBuffer*> trace_buffers;
+
+static long long traceNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - trace_epoch).count();
+}
+
+// the calling thread's buffer, registered the first time it records
+static TraceBuffer* threadBuffer()
+{
+	static thread_local TraceBuffer *buffer = NULL;
+	if (buffer == NULL)
+	{
+		std::lock_guard<std::mutex> lock(trace_buffers_lock);
+		buffer = new TraceBuffer(trace_buffers.size() + 1);
+		trace_buffers.push_back(buffer);
+	}
+	return buffer;
+}
+
+void startTracing()
+{
+	trace_epoch = std::chrono::steady_clock::now();
+	tracing.store(true);
+}
+
+
+TraceSpan::TraceSpan(const char *n, const char *an, int a) : name(n), arg_name(an), arg(a), start(-1)
+{
+	if (tracing.load(std::memory_order_relaxed))
+		start = traceNow();
+}
+
+TraceSpan::~TraceSpan()
+{
+	if (start < 0)
+		return;
+	TraceBuffer *buffer = threadBuffer();
+	unsigned long long n = buffer->count.load(std::memory_order_relaxed);
+	TraceEvent &e = buffer->events[n % TRACE_BUFFER_SIZE];
+	e.name = name;
+	e.arg_name = arg_name;
+	e.arg = arg;
+	e.start = start;
+	e.duration = traceNow() - start;
+	buffer->count.store(n + 1, std::memory_order_release);
+}
+
+
+bool writeTrace(const std::string &filename)
+{
+	FILE *file = fopen(filename.c_str(), "w");
+	if (file == NULL)
+		return false;
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	std::lock_guard<std::mutex> lock(trace_buffers_lock);
+	for (unsigned int b = 0; b < trace_buffers.size(); b++)
+	{
+		const TraceBuffer &buffer = *trace_buffers[b];
+		unsigned long long count = buffer.count.load(std::memory_order_acquire);
+		unsigned long long oldest = count > TRACE_BUFFER_SIZE ? count - TRACE_BUFFER_SIZE : 0;
+		for (unsigned long long n = oldest; n < count; n++)
+		{
+			const TraceEvent &e = buffer.events[n % TRACE_BUFFER_SIZE];
+			// timestamps are in microseconds
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+			        first ? "" : ",\n", e.name, buffer.thread_id, e.start / 1000.0, e.duration / 1000.0);
+			if (e.arg_name != NULL)
+				fprintf(file, ",\"args\":{\"%s\":%d}", e.arg_name, e.arg);
+			fprintf(file, "}");
+			first = false;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	return fclose(file) == 0;
+}
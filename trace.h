@@ -0,0 +1,47 @@
+#include <string>
+
+/****************************************************************
+trace.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Timeline of the solver phases in the Chrome trace event format
+
+*****************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+// Turn recording on.  Until this is called every TraceSpan does nothing
+// beyond testing one flag.
+void startTracing();
+
+// Write everything recorded so far as Chrome trace event JSON (load it
+// in chrome://tracing or Perfetto).  Call it once the traced threads
+// have finished.  Returns false if the file cannot be written.
+bool writeTrace(const std::string &filename);
+
+// ==================================================================
+// Records the time from its construction to its destruction as one
+// event in a ring buffer owned by the current thread, so threads never
+// wait on each other to record.  When a buffer is full the oldest
+// events are overwritten.  'name' and 'arg_name' must be string
+// literals, only the pointers are kept.
+
+class TraceSpan
+{
+	public:
+		TraceSpan(const char *name, const char *arg_name = NULL, int arg = 0);
+		~TraceSpan();
+
+	private:
+		// not copyable, each span is recorded once
+		TraceSpan(const TraceSpan&);
+		TraceSpan& operator=(const TraceSpan&);
+
+		const char *name;
+		const char *arg_name;
+		int arg;
+		// the start time in nanoseconds, -1 if tracing was off
+		long long start;
+};
+#endif
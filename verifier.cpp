@@ -0,0 +1,161 @@
+#include <cstring>
+
+#include "verifier.h"
+#include "solver.h"
+
+/****************************************************************
+verifier.cpp
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Replays submitted solutions and checks them against the puzzle
+
+*****************************************************************/
+
+
+bool parseMove(const std::string &line, command &c)
+{
+	// "Robot A moves " is 14 characters, the direction follows
+	if (line.size() < 18 || line.compare(0, 6, "Robot ") != 0 || line.compare(7, 7, " moves ") != 0)
+		return false;
+	// ignore trailing white space (and the '\r' of files with CRLF line endings)
+	std::string::size_type end = line.find_last_not_of(" \t\r");
+	const char *dir = line.c_str() + 14;
+	std::string::size_type length = end + 1 - 14;
+	for (unsigned short d = 0; d < 4; d++)
+	{
+		if (strlen(directionName(d)) == length && strncmp(dir, directionName(d), length) == 0)
+		{
+			c = command(line[6], d);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+Verifier::Verifier(const Board &b) : geometry(b)
+{
+	count = b.numRobots();
+	goal_robot = b.getGoalRobot();
+	for (int i = 0; i < MAX_ROBOTS; i++)
+		robot_id[i] = -1;
+	for (int i = 0; i < count; i++)
+	{
+		start[i] = geometry.cellIndex(b.getRobotPosition(i));
+		robot_id[b.getRobot(i) - 'A'] = i;
+	}
+	restart();
+}
+
+void Verifier::restart()
+{
+	for (int i = 0; i < count; i++)
+		robots[i] = start[i];
+	moves = 0;
+}
+
+bool Verifier::apply(const command &c)
+{
+	if (c.robot < 'A' || c.robot > 'Z' || c.dir > 3)
+		return false;
+	int i = robot_id[c.robot - 'A'];
+	if (i == -1)
+		return false;
+	int to = geometry.slide(robots, count, i, c.dir);
+	if (to == robots[i])
+		return false;
+	robots[i] = to;
+	moves++;
+	return true;
+}
+
+bool Verifier::solved() const
+{
+	return reachesGoal(robots, count, geometry.getGoal(), goal_robot);
+}
+
+
+// the outcome of one transcript, reported once it ends
+static void report(std::ostream &ostr, unsigned long n, const Verifier &v, int optimal, int illegal, const std::string &bad)
+{
+	ostr << "transcript " << n << ": ";
+	if (illegal != 0)
+		ostr << "illegal move " << illegal << " (" << bad << ")";
+	else if (!v.solved())
+		ostr << "does not reach the goal after " << v.numMoves() << " moves";
+	else if (optimal < 0)
+		ostr << "solved in " << v.numMoves() << " moves";
+	else if (v.numMoves() == optimal)
+		ostr << "solved in " << v.numMoves() << " moves, optimal";
+	else
+		ostr << "solved in " << v.numMoves() << " moves, " << v.numMoves() - optimal << " more than optimal";
+	ostr << '\n';
+}
+
+unsigned long verifyTranscripts(const Board &b, int optimal, std::istream &istr, std::ostream &ostr, SessionWriter *log)
+{
+	Verifier v(b);
+	unsigned long transcripts = 0, total_moves = 0, optimal_count = 0, solved = 0, unsolved = 0, illegal_count = 0;
+	// the number of the first illegal move in the current transcript, 0 if none
+	int illegal = 0;
+	std::string bad;
+	bool open = false;
+	std::string line;
+	command c;
+	while (true)
+	{
+		bool more = (bool)std::getline(istr, line);
+		bool move = more && parseMove(line, c);
+		if (move)
+		{
+			if (log != NULL)
+			{
+				if (!open)
+					log->startSession(b);
+				log->addMove(c);
+			}
+			open = true;
+			total_moves++;
+			if (illegal != 0)
+				continue;
+			// the game is over once the goal is reached, so moves after that are illegal too
+			if (v.solved() || !v.apply(c))
+			{
+				illegal = v.numMoves() + 1;
+				bad = line.substr(0, line.find_last_not_of(" \t\r") + 1);
+			}
+			continue;
+		}
+		// a blank line, main's summary line or the end of input closes the transcript
+		bool closes = !more || line.find_first_not_of(" \t\r") == std::string::npos || line.compare(0, 6, "robot ") == 0;
+		if (closes && open)
+		{
+			transcripts++;
+			report(ostr, transcripts, v, optimal, illegal, bad);
+			if (illegal != 0)
+				illegal_count++;
+			else if (!v.solved())
+				unsolved++;
+			else
+			{
+				solved++;
+				if (v.numMoves() == optimal)
+					optimal_count++;
+			}
+			v.restart();
+			illegal = 0;
+			open = false;
+		}
+		if (!more)
+			break;
+	}
+
+	ostr << "verified " << transcripts << " transcripts with " << total_moves << " moves: "
+	     << solved << " solved (" << optimal_count << " optimal), "
+	     << unsolved << " unsolved, " << illegal_count << " illegal" << '\n';
+	if (optimal >= 0)
+		ostr << "optimal solution uses " << optimal << " moves" << '\n';
+	else
+		ostr << "optimal solution length is unknown" << '\n';
+	return unsolved + illegal_count;
+}
@@ -0,0 +1,69 @@
+#include <iostream>
+#include <string>
+
+#include "board.h"
+#include "command.h"
+#include "geometry.h"
+#include "sessionlog.h"
+
+/****************************************************************
+verifier.h
+
+Recursive Solution to the Robot movement in Richochet Robot Game
+Replays submitted solutions and checks them against the puzzle
+
+*****************************************************************/
+
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+// parse a line in the format main prints, "Robot A moves north".
+// returns false if the line is not a move
+bool parseMove(const std::string &line, command &c);
+
+
+// ==================================================================
+// Replays moves on a lightweight copy of a Board: only the robot cells
+// are kept, and each move is a lookup in the Geometry slide-stop table.
+
+class Verifier
+{
+	public:
+		Verifier(const Board &b);
+
+		// put the robots back on their starting cells
+		void restart();
+		// apply one move; returns false (and leaves the robots where they
+		// are) if there is no such robot or the robot cannot move that way
+		bool apply(const command &c);
+
+		// ACCESSORS
+		bool solved() const;
+		int numMoves() const
+		{
+			return moves;
+		}
+
+	private:
+		// REPRESENTATION
+		Geometry geometry;
+		int count;
+		int goal_robot;
+		int start[MAX_ROBOTS];
+		int robots[MAX_ROBOTS];
+		// robot id by name, -1 if there is no robot with that name
+		int robot_id[MAX_ROBOTS];
+		int moves;
+};
+
+// Verify every transcript read from istr and print one line per
+// transcript followed by a summary.  A transcript is a sequence of move
+// lines ended by a blank line or by the "robot A reaches the goal" line
+// main prints; any other line is ignored, so main's own output can be
+// fed back in.  'optimal' is the length of the shortest solution, or -1
+// if it is not known.  If 'log' is not NULL every transcript is also
+// appended to it as a session.  Returns the number of transcripts that
+// are not valid solutions.
+unsigned long verifyTranscripts(const Board &b, int optimal, std::istream &istr, std::ostream &ostr, SessionWriter *log = NULL);
+
+#endif